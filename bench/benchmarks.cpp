@@ -0,0 +1,356 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <punky/Arena.hpp>
+#include <punky/Code.hpp>
+#include <punky/Compiler.hpp>
+#include <punky/Environment.hpp>
+#include <punky/FlatAst.hpp>
+#include <punky/Evaluator.hpp>
+#include <punky/Folder.hpp>
+#include <punky/Heap.hpp>
+#include <punky/Lexer.hpp>
+#include <punky/Object.hpp>
+#include <punky/Parser.hpp>
+#include <punky/Resolver.hpp>
+#include <punky/ThunkCompiler.hpp>
+#include <punky/VM.hpp>
+#include <punky/ast.hpp>
+
+#include "harness.hpp"
+
+namespace punky::bench
+{
+
+// Off for --opcode-pairs, which counts the sequences superinstructions replace
+static bool s_superinstructions = true;
+
+static constexpr std::string_view SNIPPET =
+  "let max = fn(x, y) { if (x > y) { x } else { y } };\n"
+  "let total = max(10, 20) * 3 + -4 / 2;\n"
+  "let check = !(total == 56) != false;\n";
+
+static constexpr std::string_view FIB =
+  "let fib = fn(n) { if (n < 2) { n } else { fib(n - 1) + fib(n - 2) } };";
+
+// Nested closures that read variables from every enclosing scope
+static constexpr std::string_view CLOSURES =
+  "let deep = fn(a) {"
+  "  let mid = fn(b) { let inner = fn(c) { a + b + c }; inner(b * 2) };"
+  "  mid(a + 1)"
+  "};"
+  "let sum = fn(n, acc) { if (n == 0) { acc } else { sum(n - 1, acc + deep(n)) } };";
+
+// Reads globals so the Folder leaves it alone. Every engine takes 8 steps per
+// line: the VM runs 4 GetGlobals, Mul, Add, Sub and Pop, the Evaluator visits
+// the statement, 3 infix expressions and 4 identifiers, and the thunk engine
+// calls the Thunks of those 7 expressions from its statement loop.
+static constexpr std::string_view DISPATCH_DEFS = "let a = 3;";
+static constexpr std::string_view DISPATCH_LINE = "a + a * a - a;\n";
+static constexpr int              DISPATCH_STEPS_PER_LINE = 8;
+static constexpr int              DISPATCH_LINES          = 1000;
+
+static auto repeat(std::string_view text, int times) -> std::string
+{
+    std::string out;
+    out.reserve(text.size() * static_cast<std::size_t>(times));
+    for (int i = 0; i < times; ++i)
+        out.append(text);
+    return out;
+}
+
+// Identifiers are letters only: va, vb, ..., vz, vba, ... The prefix keeps
+// them clear of keywords.
+static auto letter_name(int index) -> std::string
+{
+    std::string name;
+    do
+    {
+        name.insert(name.begin(), static_cast<char>('a' + index % 26));
+        index /= 26;
+    } while (index > 0);
+    return "v" + name;
+}
+
+static auto let_chain(int length) -> std::string
+{
+    std::string src = "let " + letter_name(0) + " = 1;";
+    for (int i = 1; i < length; ++i)
+        src += " let " + letter_name(i) + " = " + letter_name(i - 1) + " + 1;";
+    return src + " " + letter_name(length - 1);
+}
+
+static auto parse_folded(ast::Arena& arena, std::string_view src) -> ast::Program*
+{
+    auto lex  = lex::Lexer{arena.copy_source(src)};
+    auto par  = par::Parser{lex, arena};
+    auto prog = std::get<ast::Program*>(par.parse_program());
+    opt::Folder{arena}.fold(*prog);
+    return prog;
+}
+
+// Definitions run once, untimed, in the globals the timed call then uses
+static auto evaluator_workload(std::string_view defs, std::string_view call) -> Loop
+{
+    auto arena    = std::make_shared<ast::Arena>();
+    auto resolver = std::make_shared<resolve::Resolver>();
+    auto env      = env::Environment::make();
+    auto env_root = std::make_shared<gc::Root>(env);
+
+    auto parse = [&](std::string_view src) {
+        auto* prog = parse_folded(*arena, src);
+        resolver->resolve(*prog);
+        return prog;
+    };
+
+    const auto* defs_prog = parse(defs);
+    const auto* call_prog = parse(call);
+    do_not_optimize(eval::Evaluator{*defs_prog}.interpret(*env));
+
+    return [arena, resolver, env, env_root, call_prog](std::uint64_t n) {
+        auto evaluator = eval::Evaluator{*call_prog};
+        for (std::uint64_t i = 0; i < n; ++i)
+            do_not_optimize(evaluator.interpret(*env));
+    };
+}
+
+static auto thunks_workload(std::string_view defs, std::string_view call) -> Loop
+{
+    auto arena    = std::make_shared<ast::Arena>();
+    auto resolver = std::make_shared<resolve::Resolver>();
+    auto compiler = std::make_shared<thunk::ThunkCompiler>();
+    auto env      = env::Environment::make();
+    auto env_root = std::make_shared<gc::Root>(env);
+
+    auto compile = [&](std::string_view src) {
+        auto* prog = parse_folded(*arena, src);
+        resolver->resolve(*prog);
+        return compiler->compile(*prog);
+    };
+
+    do_not_optimize(compile(defs)(*env));
+    auto code = std::make_shared<thunk::Thunk>(compile(call));
+
+    return [arena, resolver, compiler, env, env_root, code](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i)
+            do_not_optimize((*code)(*env));
+    };
+}
+
+static auto vm_workload(std::string_view defs, std::string_view call) -> Loop
+{
+    auto arena    = std::make_shared<ast::Arena>();
+    auto compiler = std::make_shared<compile::Compiler>(s_superinstructions);
+    auto machine  = std::make_shared<vm::VM>();
+
+    auto compile = [&](std::string_view src) {
+        auto lex  = lex::Lexer{arena->copy_source(src)};
+        auto flat = ast::FlatAst{};
+        std::get<const ast::FlatAst*>(par::FlatParser{lex, flat}.parse_program());
+        return compiler->compile(std::move(flat));
+    };
+
+    do_not_optimize(machine->run(compile(defs)));
+    auto code = std::make_shared<compile::Bytecode>(compile(call));
+
+    return [arena, compiler, machine, code](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i)
+            do_not_optimize(machine->run(*code));
+    };
+}
+
+static auto lexer_next_token(const std::string& src) -> Loop
+{
+    return [src](std::uint64_t n) {
+        auto lex = lex::Lexer{src};
+        for (std::uint64_t i = 0; i < n; ++i)
+        {
+            auto tok = lex.next_token();
+            if (tok.m_type == tok::TokenType::EOS)
+                lex = lex::Lexer{src};
+            do_not_optimize(tok);
+        }
+    };
+}
+
+static auto parser_parse_program(const std::string& src) -> Loop
+{
+    return [src](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i)
+        {
+            auto arena = ast::Arena{};
+            auto lex   = lex::Lexer{src};
+            auto par   = par::Parser{lex, arena};
+            do_not_optimize(par.parse_program());
+        }
+    };
+}
+
+static auto flat_parser_parse_program(const std::string& src) -> Loop
+{
+    return [src](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i)
+        {
+            auto flat = ast::FlatAst{};
+            auto lex  = lex::Lexer{src};
+            auto par  = par::FlatParser{lex, flat};
+            do_not_optimize(par.parse_program());
+        }
+    };
+}
+
+static auto environment_get() -> Loop
+{
+    // A call nested two functions deep reading slots from every level
+    auto globals = env::Environment::make();
+    for (std::size_t slot = 0; slot < 8; ++slot)
+        globals->set(slot, obj::Object{static_cast<std::int64_t>(slot)});
+
+    auto outer = env::Environment::make(globals, 4);
+    auto inner = env::Environment::make(outer, 4);
+    auto root  = std::make_shared<gc::Root>(inner);
+    for (std::size_t slot = 0; slot < 4; ++slot)
+    {
+        outer->set(slot, obj::Object{true});
+        inner->set(slot, obj::Object{false});
+    }
+
+    return [inner, root](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i)
+            do_not_optimize(inner->get(i % 3, i % 4));
+    };
+}
+
+static auto count_tokens(const std::string& src) -> double
+{
+    auto   lex    = lex::Lexer{src};
+    double tokens = 0;
+    while (lex.next_token().m_type != tok::TokenType::EOS)
+        ++tokens;
+    return tokens + 1;
+}
+
+static auto benchmarks() -> std::vector<Benchmark>
+{
+    static const auto source    = repeat(SNIPPET, 1000);
+    static const auto chain     = let_chain(1000);
+    static const auto snippet   = std::string{SNIPPET};
+    static const auto dispatch  = repeat(DISPATCH_LINE, DISPATCH_LINES);
+    const auto        steps     = static_cast<double>(DISPATCH_STEPS_PER_LINE * DISPATCH_LINES);
+    const auto        token_len = static_cast<double>(source.size()) / count_tokens(source);
+
+    return {
+      {"lexer/next_token", [] { return lexer_next_token(source); }, token_len},
+      {"parser/parse_program", [] { return parser_parse_program(snippet); },
+       static_cast<double>(snippet.size())},
+      {"parser/parse_program/flat", [] { return flat_parser_parse_program(snippet); },
+       static_cast<double>(snippet.size())},
+      {"parser/parse_program/large", [] { return parser_parse_program(source); },
+       static_cast<double>(source.size())},
+      {"parser/parse_program/flat/large", [] { return flat_parser_parse_program(source); },
+       static_cast<double>(source.size())},
+      {"evaluator/interpret", [] { return evaluator_workload("", SNIPPET); }},
+      {"environment/get", [] { return environment_get(); }},
+      {"dispatch/evaluator", [] { return evaluator_workload(DISPATCH_DEFS, dispatch); }, 0, steps},
+      {"dispatch/thunks", [] { return thunks_workload(DISPATCH_DEFS, dispatch); }, 0, steps},
+      {"dispatch/vm", [] { return vm_workload(DISPATCH_DEFS, dispatch); }, 0, steps},
+
+      {"macro/fib/evaluator", [] { return evaluator_workload(FIB, "fib(20)"); }},
+      {"macro/fib/thunks", [] { return thunks_workload(FIB, "fib(20)"); }},
+      {"macro/fib/vm", [] { return vm_workload(FIB, "fib(20)"); }},
+      {"macro/closures/evaluator", [] { return evaluator_workload(CLOSURES, "sum(500, 0)"); }},
+      {"macro/closures/thunks", [] { return thunks_workload(CLOSURES, "sum(500, 0)"); }},
+      {"macro/closures/vm", [] { return vm_workload(CLOSURES, "sum(500, 0)"); }},
+      {"macro/let_chain/evaluator", [] { return evaluator_workload("", chain); },
+       static_cast<double>(chain.size())},
+      {"macro/let_chain/thunks", [] { return thunks_workload("", chain); },
+       static_cast<double>(chain.size())},
+      {"macro/let_chain/vm", [] { return vm_workload("", chain); },
+       static_cast<double>(chain.size())},
+    };
+}
+
+// The most frequent pairs in vm::opcode_pairs()
+static auto top_pairs(std::size_t count) -> std::vector<PairCount>
+{
+    std::vector<PairCount> pairs;
+    const auto&            counts = vm::opcode_pairs();
+    for (std::size_t first = 0; first < code::NUM_OPCODES; ++first)
+    {
+        for (std::size_t second = 0; second < code::NUM_OPCODES; ++second)
+        {
+            if (counts[first][second] == 0)
+                continue;
+
+            auto name = std::string{code::to_string(static_cast<code::OpCode>(first))} + " "
+                        + std::string{code::to_string(static_cast<code::OpCode>(second))};
+            pairs.push_back(PairCount{std::move(name), counts[first][second]});
+        }
+    }
+
+    std::sort(pairs.begin(), pairs.end(),
+              [](const PairCount& lhs, const PairCount& rhs) { return lhs.m_count > rhs.m_count; });
+    pairs.resize(std::min(pairs.size(), count));
+    return pairs;
+}
+
+}  // namespace punky::bench
+
+int main(int argc, char* argv[])
+{
+    using punky::bench::Result;
+
+    std::string_view filter;
+    double           min_time_ms  = 200;
+    bool             opcode_pairs = false;
+
+    const std::vector<std::string_view> args(argv + 1, argv + argc);
+    for (std::size_t i = 0; i < args.size(); ++i)
+    {
+        if (args[i] == "--filter" && i + 1 < args.size())
+            filter = args[++i];
+        else if (args[i] == "--min-time-ms" && i + 1 < args.size())
+            min_time_ms = std::stod(std::string{args[++i]});
+        else if (args[i] == "--opcode-pairs")
+            opcode_pairs = true;
+        else
+        {
+            std::cerr << "usage: punky_bench [--filter <substring>] [--min-time-ms <ms>] [--opcode-pairs]\n";
+            return 1;
+        }
+    }
+
+    if (opcode_pairs)
+    {
+        if (!punky::vm::PROFILES_OPCODES)
+        {
+            std::cerr << "punky_bench: --opcode-pairs needs a build configured with -DPUNKY_VM_PROFILE=ON\n";
+            return 1;
+        }
+        punky::bench::s_superinstructions = false;
+    }
+
+    std::vector<Result> results;
+    for (const auto& bench : punky::bench::benchmarks())
+    {
+        if (bench.m_name.find(filter) != std::string::npos)
+        {
+            std::cerr << bench.m_name << "...\n";
+            results.push_back(punky::bench::run(bench, min_time_ms));
+        }
+    }
+
+    static constexpr std::size_t TOP_PAIRS = 20;
+    punky::bench::write_json(std::cout, results,
+                             opcode_pairs ? punky::bench::top_pairs(TOP_PAIRS)
+                                          : std::vector<punky::bench::PairCount>{});
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "harness.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <ostream>
+#include <vector>
+
+#include <punky/Heap.hpp>
+
+static std::uint64_t g_allocations = 0;
+
+void* operator new(std::size_t size)
+{
+    ++g_allocations;
+    if (auto* ptr = std::malloc(size != 0 ? size : 1); ptr)
+        return ptr;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept
+{
+    std::free(ptr);
+}
+
+namespace punky::bench
+{
+
+auto run(const Benchmark& bench, double min_time_ms) -> Result
+{
+    using Clock = std::chrono::steady_clock;
+
+    const auto loop = bench.m_setup();
+
+    std::uint64_t iterations = 1;
+    while (true)
+    {
+        const auto allocs_before = g_allocations;
+        const auto heap_before   = gc::heap().stats();
+        const auto start         = Clock::now();
+
+        loop(iterations);
+
+        const auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        const auto allocs  = g_allocations - allocs_before;
+
+        const auto& heap_after   = gc::heap().stats();
+        const auto  heap_objects = (heap_after.m_allocated_objects + heap_after.m_young_objects)
+                                  - (heap_before.m_allocated_objects + heap_before.m_young_objects);
+        const auto heap_bytes = (heap_after.m_allocated_bytes + heap_after.m_young_bytes)
+                                - (heap_before.m_allocated_bytes + heap_before.m_young_bytes);
+
+        if (elapsed >= min_time_ms * 1e6 || iterations >= (std::uint64_t{1} << 40))
+        {
+            const auto n = static_cast<double>(iterations);
+            return Result{bench.m_name,
+                          iterations,
+                          elapsed / n,
+                          static_cast<double>(allocs) / n,
+                          static_cast<double>(heap_objects) / n,
+                          static_cast<double>(heap_bytes) / n,
+                          bench.m_bytes_per_op,
+                          bench.m_steps_per_op};
+        }
+
+        // Aim a little past the target so the next run is usually the last
+        const auto per_op = elapsed > 0 ? elapsed / static_cast<double>(iterations) : 1.0;
+        const auto wanted = static_cast<std::uint64_t>(min_time_ms * 1e6 * 1.2 / per_op);
+        iterations        = std::max(iterations * 2, std::min(wanted, iterations * 100));
+    }
+}
+
+void write_json(std::ostream& out, const std::vector<Result>& results,
+                const std::vector<PairCount>& pairs)
+{
+    out << std::fixed << std::setprecision(3) << "{\n  \"benchmarks\": [";
+
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const auto& res = results[i];
+        out << (i ? ",\n" : "\n")
+            << "    {\"name\": \"" << res.m_name << "\""
+            << ", \"iterations\": " << res.m_iterations
+            << ", \"ns_per_op\": " << res.m_ns_per_op
+            << ", \"allocs_per_op\": " << res.m_allocs_per_op
+            << ", \"heap_objects_per_op\": " << res.m_heap_objects_per_op
+            << ", \"heap_bytes_per_op\": " << res.m_heap_bytes_per_op
+            << ", \"ops_per_sec\": " << 1e9 / res.m_ns_per_op;
+
+        if (res.m_bytes_per_op > 0)
+            out << ", \"bytes_per_sec\": " << res.m_bytes_per_op * 1e9 / res.m_ns_per_op;
+
+        if (res.m_steps_per_op > 0)
+            out << ", \"ns_per_step\": " << res.m_ns_per_op / res.m_steps_per_op;
+
+        out << "}";
+    }
+    out << "\n  ]";
+
+    if (!pairs.empty())
+    {
+        out << ",\n  \"opcode_pairs\": [";
+        for (std::size_t i = 0; i < pairs.size(); ++i)
+        {
+            out << (i ? ",\n" : "\n") << "    {\"pair\": \"" << pairs[i].m_pair << "\""
+                << ", \"count\": " << pairs[i].m_count << "}";
+        }
+        out << "\n  ]";
+    }
+
+    out << "\n}\n";
+}
+
+}  // namespace punky::bench
@@ -0,0 +1,64 @@
+#ifndef BENCH_HARNESS_HPP
+#define BENCH_HARNESS_HPP
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace punky::bench
+{
+
+// Runs a benchmark's operation n times
+using Loop = std::function<void(std::uint64_t n)>;
+
+struct Benchmark
+{
+    std::string           m_name;
+    std::function<Loop()> m_setup;  // Untimed, builds the inputs the Loop runs on
+    double                m_bytes_per_op{};
+
+    // Opcodes the VM executes, or nodes the Evaluator visits, per operation
+    double m_steps_per_op{};
+};
+
+struct Result
+{
+    std::string   m_name;
+    std::uint64_t m_iterations;
+    double        m_ns_per_op;
+    double        m_allocs_per_op;
+    double        m_heap_objects_per_op;
+    double        m_heap_bytes_per_op;
+    double        m_bytes_per_op;
+    double        m_steps_per_op;
+};
+
+// Grows the iteration count until one timed run lasts at least min_time_ms.
+// Allocations are counted through the replaced global operator new, and
+// Objects and Environments, which gc::Heap carves out of pages and nursery
+// chunks of its own, from the difference in its HeapStats.
+auto run(const Benchmark& bench, double min_time_ms) -> Result;
+
+// How often the VM ran one opcode right after another, as "First Second"
+struct PairCount
+{
+    std::string   m_pair;
+    std::uint64_t m_count;
+};
+
+// The pairs, most frequent first, are only written if there are any
+void write_json(std::ostream& out, const std::vector<Result>& results,
+                const std::vector<PairCount>& pairs = {});
+
+// Keeps the compiler from discarding a value that is otherwise unused
+template <typename T>
+inline void do_not_optimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+}  // namespace punky::bench
+
+#endif  // BENCH_HARNESS_HPP
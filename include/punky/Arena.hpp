@@ -0,0 +1,67 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace punky::ast
+{
+
+// A bump allocator owning every node of the Programs parsed into it.
+// Nodes live until the Arena does, so a REPL session keeps one Arena and
+// function literals stay valid for as long as closures refer to them.
+class Arena
+{
+public:
+    Arena() = default;
+    Arena(Arena const& other) = delete;
+    Arena& operator=(Arena const& other) = delete;
+    Arena(Arena&& other)                 = delete;
+    Arena& operator=(Arena&& other) = delete;
+    ~Arena();
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args)
+    {
+        auto* obj = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+        // Trivially destructible nodes are simply dropped with their block
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            m_dtors.push_back(Dtor{obj, [](void* p) { static_cast<T*>(p)->~T(); }});
+
+        return obj;
+    }
+
+    // Keeps a copy of source text for the session, so the Tokens and nodes
+    // lexed from it can refer to it instead of owning strings.
+    auto copy_source(std::string_view source) -> std::string_view;
+
+    [[nodiscard]] std::size_t bytes_allocated() const { return m_bytes; }
+
+private:
+    static constexpr std::size_t BLOCK_SIZE = 16 * 1024;
+
+    struct Dtor
+    {
+        void* m_obj;
+        void (*m_destroy)(void*);
+    };
+
+    std::vector<std::unique_ptr<std::byte[]>> m_blocks;
+    std::vector<Dtor>                         m_dtors;
+
+    std::byte*  m_cursor{};
+    std::byte*  m_end{};
+    std::size_t m_bytes{};
+
+    auto allocate(std::size_t size, std::size_t align) -> void*;
+};
+
+}  // namespace punky::ast
+
+#endif  // ARENA_HPP
@@ -0,0 +1,77 @@
+#ifndef COBJECT_HPP
+#define COBJECT_HPP
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Code.hpp"
+#include "FlatAst.hpp"
+#include "Object.hpp"
+
+namespace punky::obj
+{
+
+// A function body lowered by the compiler. Unlike FunctionObject, running
+// it never reads the AST, which the Compiler keeps only to print it.
+struct CompiledFunction
+{
+    code::Instructions  m_instructions;
+    std::uint32_t       m_num_locals{};
+    std::uint32_t       m_num_params{};
+    const ast::FlatAst* m_ast{};
+    ast::NodeId         m_node{ast::NO_NODE};
+
+    // Printed by inspect()
+    [[nodiscard]] std::string source() const { return m_ast->to_string(m_node); }
+};
+
+// The Cells a closure captured
+using FreeVariables = std::vector<Object>;
+
+class ClosureObject : public HeapObject
+{
+public:
+    ClosureObject(const CompiledFunction* fn, FreeVariables free) :
+      m_fn{fn},
+      m_free{std::move(free)}
+    {}
+
+    [[nodiscard]] const CompiledFunction& fn() const { return *m_fn; }
+    [[nodiscard]] const FreeVariables&    free() const { return m_free; }
+
+    void trace(gc::Tracer& tracer) const override;
+
+private:
+    // Owned by the Compiler
+    const CompiledFunction* m_fn;
+
+    FreeVariables m_free;
+};
+
+// A slot of a call that a closure made by the call captures. The call and
+// every such closure share the Cell, so each sees what the others bind.
+class CellObject : public HeapObject
+{
+public:
+    explicit CellObject(Object value) :
+      m_value{value}
+    {}
+
+    [[nodiscard]] const Object& value() const { return m_value; }
+    void                        set(Object value) { m_value = value; }
+
+    void trace(gc::Tracer& tracer) const override;
+
+private:
+    Object m_value;
+};
+
+Object make_closure(const CompiledFunction* fn, FreeVariables free);
+
+Object make_cell(Object value);
+
+}  // namespace punky::obj
+
+#endif  // COBJECT_HPP
@@ -0,0 +1,118 @@
+#ifndef CALLSTACK_HPP
+#define CALLSTACK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <utility>
+#include <vector>
+
+#include "Environment.hpp"
+#include "Heap.hpp"
+#include "Object.hpp"
+
+// Switching to a stack segment needs ucontext and mmap, so only POSIX
+// systems get segments
+#if __has_include(<ucontext.h>) && __has_include(<sys/mman.h>)
+#    define PUNKY_STACK_SEGMENTS
+#endif
+
+namespace punky::eval
+{
+
+// The Evaluator's punky call frames, kept on the heap rather than implied by
+// the C++ stack, and the roots for the Environments of running calls.
+//
+// The Evaluator still recurses natively, so a call that finds the native
+// stack nearly used up continues on a fresh segment of stack allocated here.
+// Recursion is then only bounded by the maximum depth, and going past it is
+// an Error Object instead of a crash.
+//
+// Without PUNKY_STACK_SEGMENTS every call runs on the native stack, and
+// recursion that exhausts it before the maximum depth still crashes.
+class CallStack : public gc::RootSet
+{
+public:
+    explicit CallStack(std::size_t max_depth);
+    ~CallStack() override;
+
+    // Returns false, pushing nothing, if the stack is at its maximum depth
+    [[nodiscard]] bool push(env::Environment* env)
+    {
+        if (m_frames.size() == m_max_depth)
+            return false;
+
+        if (m_frames.empty())
+            set_native_limit(MAIN_STACK_BUDGET);
+
+        m_frames.push_back(env);
+        return true;
+    }
+
+    void pop() { m_frames.pop_back(); }
+
+    [[nodiscard]] std::size_t max_depth() const { return m_max_depth; }
+
+    // Returns call(), run on a new stack segment if less than SEGMENT_RESERVE
+    // bytes of the current one are left. An exception thrown by call() on a
+    // segment cannot unwind past the segment's first frame, so it is caught
+    // there and thrown again from here.
+    template <typename Call>
+    auto run(Call&& call) -> obj::Object
+    {
+#ifdef PUNKY_STACK_SEGMENTS
+        const char here{};
+        if (reinterpret_cast<std::uintptr_t>(&here) > m_native_limit)
+            return call();
+
+        auto result = obj::Object{};
+        auto thrown = std::exception_ptr{};
+        auto entry  = [&call, &result, &thrown]() {
+            try
+            {
+                result = call();
+            }
+            catch (...)
+            {
+                thrown = std::current_exception();
+            }
+        };
+        using Entry = decltype(entry);
+        run_on_segment([](void* arg) { (*static_cast<Entry*>(arg))(); }, &entry);
+
+        if (thrown)
+            std::rethrow_exception(thrown);
+        return result;
+#else
+        return call();
+#endif
+    }
+
+    void trace(gc::Tracer& tracer) const override;
+
+private:
+    // What the first call may use of the stack the Evaluator was entered on,
+    // and what each segment leaves for the calls between two checks.
+    static constexpr std::size_t MAIN_STACK_BUDGET = 1024 * 1024;
+    static constexpr std::size_t SEGMENT_SIZE      = 8 * 1024 * 1024;
+    static constexpr std::size_t SEGMENT_RESERVE   = 256 * 1024;
+
+    std::size_t                    m_max_depth;
+    std::vector<env::Environment*> m_frames;
+
+    // Segments are mapped on first use and reused by later deep calls
+    std::vector<void*> m_segments;
+    std::size_t        m_segments_used{};
+
+    // The native stack grows down, towards this address
+    std::uintptr_t m_native_limit{};
+
+    void set_native_limit(std::size_t budget);
+
+    // entry must not throw
+    void run_on_segment(void (*entry)(void*), void* arg);
+};
+
+}  // namespace punky::eval
+
+#endif  // CALLSTACK_HPP
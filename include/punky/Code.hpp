@@ -0,0 +1,87 @@
+#ifndef CODE_HPP
+#define CODE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+#include <vector>
+
+namespace punky::code
+{
+
+// Every operand is a u32, little endian. Narrower ones would have to be
+// checked against each count the Compiler keeps, which a long script can
+// outgrow, while no Program gets near 2^32 of anything.
+inline constexpr std::size_t OPERAND_WIDTH = 4;
+
+// clang-format off
+enum class OpCode : std::uint8_t
+{
+    // Operands              Stack
+    Constant,        // const       -> value
+    Pop,             //             value ->
+
+    Null,            //             -> null
+    True,            //             -> true
+    False,           //             -> false
+    Empty,           //             -> (empty output, result of a let)
+
+    Add, Sub,        //             left right -> result
+    Mul, Div,
+    Equal, NotEqual,
+    Greater, Less,
+
+    Minus, Bang,     //             right -> result
+
+    Jump,            // target
+    JumpNotTruthy,   // target      cond ->
+    JumpIfBound,     // target      value -> value, or nothing if it is unbound
+
+    GetGlobal,       // slot        -> value
+    SetGlobal,       // slot        value ->
+    GetLocal,        // slot        -> value, or the Cell in the slot
+    SetLocal,        // slot        value ->
+    MakeCell,        // slot                    (puts the slot's value in a Cell)
+    GetCell,         // slot        -> the value in the slot's Cell
+    SetCell,         // slot        value ->
+    GetFree,         // index       -> the value in the free variable's Cell
+    GetFreeCell,     // index       -> the free variable's Cell
+
+    Closure,         // const, free count    free Cells... -> closure
+
+    Call,            // argc        fn args... -> result
+    TailCall,        // argc        fn args... ->   (replaces the running frame)
+    ReturnValue,     //             value ->
+
+    // Superinstructions, fused by the Compiler from the sequences above
+    AddLocalConst,     // slot, const    -> local + const
+    SubLocalConst,     // slot, const    -> local - const
+    JumpIfNotLess,     // target      left right ->
+    JumpIfNotGreater,  // target      left right ->
+    JumpIfNotEqual,    // target      left right ->
+};
+// clang-format on
+
+inline constexpr std::size_t NUM_OPCODES = static_cast<std::size_t>(OpCode::JumpIfNotEqual) + 1;
+
+// The enumerator's name, as in "GetLocal"
+auto to_string(OpCode op) -> std::string_view;
+
+using Instructions = std::vector<std::uint8_t>;
+
+// Appends op and its operands to ins, returning the offset of the opcode.
+auto emit(Instructions& ins, OpCode op, std::initializer_list<int> operands) -> std::size_t;
+
+// Overwrites the first operand of the instruction at pos.
+void patch_operand(Instructions& ins, std::size_t pos, int operand);
+
+inline auto read_operand(const std::uint8_t* ip) -> std::uint32_t
+{
+    return static_cast<std::uint32_t>(ip[0]) | (static_cast<std::uint32_t>(ip[1]) << 8)
+           | (static_cast<std::uint32_t>(ip[2]) << 16) | (static_cast<std::uint32_t>(ip[3]) << 24);
+}
+
+}  // namespace punky::code
+
+#endif  // CODE_HPP
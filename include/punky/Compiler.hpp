@@ -0,0 +1,91 @@
+#ifndef COMPILER_HPP
+#define COMPILER_HPP
+
+#include <cstddef>
+#include <deque>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+#include "CObject.hpp"
+#include "Code.hpp"
+#include "FlatAst.hpp"
+#include "FlatResolver.hpp"
+#include "Folder.hpp"
+#include "Heap.hpp"
+#include "Object.hpp"
+#include "Symbol.hpp"
+#include "ast.hpp"
+
+namespace punky::compile
+{
+
+// Constants, compiled functions and global names are owned by the Compiler,
+// which must outlive any Bytecode or closure it hands out. Both only grow, so REPL lines compiled by the
+// same Compiler can refer to each other's globals.
+struct Bytecode
+{
+    code::Instructions              m_instructions;
+    const std::vector<obj::Object>* m_constants;
+    const std::vector<sym::SymbolId>* m_global_names;
+};
+
+class Compiler
+{
+public:
+    // Without superinstructions, the Compiler emits only the sequences they
+    // replace, to count which ones are worth fusing
+    explicit Compiler(bool superinstructions = true) :
+      m_superinstructions{superinstructions}
+    {}
+
+    // ast is kept, as the compiled functions print their source from it
+    auto compile(ast::FlatAst ast) -> Bytecode;
+
+private:
+    struct Scope
+    {
+        code::Instructions           m_instructions;
+        const resolve::FlatFunction* m_fn;
+    };
+
+    bool m_superinstructions;
+
+    std::vector<obj::Object>                            m_constants;
+    gc::Root                                            m_constants_root{m_constants};
+    std::vector<std::unique_ptr<obj::CompiledFunction>> m_functions;
+    resolve::FlatResolver                               m_resolver;
+
+    code::Instructions m_main;
+    std::vector<Scope> m_scopes;
+
+    // Every Program compiled so far, as par::FlatParser emitted it
+    std::deque<ast::FlatAst> m_asts;
+
+    // The one being compiled, and what folding it would do
+    const ast::FlatAst* m_ast{};
+    opt::FlatFolds      m_folds;
+
+    auto instructions() -> code::Instructions&;
+
+    auto emit(code::OpCode op, std::initializer_list<int> operands = {}) -> std::size_t;
+    auto add_constant(obj::Object obj) -> int;
+
+    void compile_block(ast::NodeId block);
+    void compile_statement(ast::NodeId stmt);
+    void compile_let(ast::NodeId let);
+    void compile_expression(ast::NodeId expr);
+    void compile_identifier(ast::NodeId ident);
+    void compile_if(ast::NodeId if_expr);
+    auto compile_condition(ast::NodeId cond) -> std::size_t;
+    auto compile_local_const(ast::NodeId infix) -> bool;
+    void compile_call(ast::NodeId call);
+    void compile_function(ast::NodeId fn);
+
+    // Whether binding is a slot of the running call that holds a Cell
+    [[nodiscard]] bool is_cell(const resolve::Binding& binding) const;
+};
+
+}  // namespace punky::compile
+
+#endif  // COMPILER_HPP
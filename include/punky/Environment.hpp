@@ -1,30 +1,80 @@
 #ifndef ENVIRONMENT_HPP
 #define ENVIRONMENT_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <optional>
-#include <string>
-#include <unordered_map>
+#include <vector>
 
 #include "Object.hpp"
 
 namespace punky::env
 {
 
-class Environment
+// A flat array of bindings, addressed by the (depth, slot) pairs that
+// resolve::Resolver assigns, so a lookup never hashes a name.
+//
+// Environments live in gc::heap(): one stays alive while a call runs in it,
+// while a function created in it is reachable, or while a gc::Root holds it.
+class Environment : public obj::HeapObject
 {
 public:
-    Environment() = default;
-    explicit Environment(Environment* outer) :
-      m_outer{outer}
-    {}
+    // Nothing refers to the result yet, so the caller must make it reachable
+    // before the next safepoint.
+    static auto make(Environment* outer = nullptr, std::size_t num_slots = 0) -> Environment*;
+
+    // For a call whose Environment cannot escape it: the Environment and its
+    // slots are one allocation in the nursery, and the caller must release()
+    // it once the call returns.
+    static auto make_young(Environment* outer, std::size_t num_slots) -> Environment*;
+    static void release(Environment* env);
+
+    auto set(std::size_t slot, const obj::Object& value) -> obj::Object;
+    auto get(std::size_t depth, std::size_t slot) const -> std::optional<obj::Object>;
+
+    // Changes whenever set() does, and is never shared by two Environments,
+    // so a cached read stays valid for as long as the version it saw.
+    [[nodiscard]] std::uint64_t version() const { return m_version; }
 
-    auto set(std::string name, const obj::Object& value) -> obj::Object;
-    auto get(const std::string& name) const -> std::optional<obj::Object>;
+    void trace(gc::Tracer& tracer) const override;
 
 private:
-    std::unordered_map<std::string, obj::Object> m_store;
+    friend class gc::Heap;
+
+    using Slot = std::optional<obj::Object>;
+
+    Environment(Environment* outer, std::size_t num_slots) :
+      m_slots{},
+      m_num_slots{num_slots},
+      m_storage(num_slots),
+      m_outer{outer}
+    {
+        m_slots = m_storage.data();
+    }
+
+    // The slots directly follow a young Environment
+    Environment(Environment* outer, std::size_t num_slots, bool /*young*/) :
+      m_slots{reinterpret_cast<Slot*>(this + 1)},
+      m_num_slots{num_slots},
+      m_outer{outer}
+    {
+        std::uninitialized_value_construct_n(m_slots, num_slots);
+    }
+
+    void grow(std::size_t num_slots);
+
+    // A slot stays empty until a let or a call binds it. The global
+    // Environment grows as later REPL lines define new names.
+    Slot*             m_slots;
+    std::size_t       m_num_slots;
+    std::vector<Slot> m_storage;
+
+    Environment* m_outer;
+
+    static std::uint64_t next_version();
 
-    Environment* m_outer{};
+    std::uint64_t m_version{next_version()};
 };
 }  // namespace punky::env
 
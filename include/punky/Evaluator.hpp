@@ -1,13 +1,17 @@
 #ifndef EVALUATOR_HPP
 #define EVALUATOR_HPP
 
-#include <memory>
+#include <cstddef>
+#include <optional>
 #include <vector>
 
+#include "CallStack.hpp"
 #include "Environment.hpp"
+#include "Heap.hpp"
 #include "Object.hpp"
 #include "Token.hpp"
 #include "ast.hpp"
+#include "operators.hpp"
 
 namespace punky::eval
 {
@@ -20,37 +24,44 @@ using ObjectVector = std::vector<Object>;
 class Evaluator
 {
 public:
-    explicit Evaluator(std::unique_ptr<ast::Program> prog);
+    explicit Evaluator(const ast::Program& prog, std::size_t max_depth = ops::DEFAULT_MAX_DEPTH);
 
-    [[nodiscard]] Object interpret(env::Environment& env) const;
+    [[nodiscard]] Object interpret(env::Environment& env);
 
 private:
-    std::unique_ptr<ast::Program> m_program;
+    // Owned by the ast::Arena it was parsed into
+    const ast::Program* m_program;
 
-    static const Object M_TRUE_OBJ;
-    static const Object M_FALSE_OBJ;
-    static const Object M_NULL_OBJ;
+    CallStack m_calls;
+
+    // Where global identifiers are read, the Environment interpret() runs in
+    const env::Environment* m_globals{};
 
-    [[nodiscard]] Object eval_program(env::Environment& env) const;
+    // The callee and arguments of every call being set up, so they are
+    // rooted until bound in the callee's Environment.
+    ObjectVector m_args;
+    gc::Root     m_args_root{m_args};
 
-    static Object eval(const ast::AstNode& node, env::Environment& env);
+    // A call in tail position leaves its callee and arguments here, for the
+    // apply_function() running the enclosing call to make in its place.
+    ObjectVector m_tail_call;
+    gc::Root     m_tail_call_root{m_tail_call};
+
+    static const Object M_NULL_OBJ;
 
-    static Object eval_block_statements(const ast::BlockStmt& block, env::Environment& env);
+    [[nodiscard]] Object eval_program(env::Environment& env);
 
-    static Object eval_prefix_expr(const TokenType& op, const Object& right);
-    static Object eval_bang_prefix_expr(const Object& right);
-    static Object eval_minus_prefix_expr(const Object& right);
+    Object eval(const ast::AstNode& node, env::Environment& env);
 
-    static Object eval_infix_expr(const TokenType& op, const Object& left, const Object& right);
-    static Object eval_int_infix_expr(const TokenType& op, const Object& left, const Object& right);
-    static Object eval_bool_infix_expr(const TokenType& op, const Object& left, const Object& right);
+    Object eval_block_statements(const ast::BlockStmt& block, env::Environment& env);
 
-    static Object eval_if_expr(const ast::IfExpression& if_expr, env::Environment& env);
-    static Object eval_identifier(const ast::Identifier& ident, const env::Environment& env);
+    Object eval_if_expr(const ast::IfExpression& if_expr, env::Environment& env);
+    Object eval_identifier(const ast::Identifier& ident, const env::Environment& env) const;
 
-    static ObjectVector eval_expressions(const ast::ExprNodeVector* exprs, env::Environment& env);
+    std::optional<Object> eval_arguments(const ast::ExprNodeVector* exprs, env::Environment& env);
 
-    static Object apply_function(const Object& fn, const ObjectVector& args);
+    // Calls the function at m_args[base] with the arguments above it
+    Object apply_function(std::size_t base);
 };
 
 }  // namespace punky::eval
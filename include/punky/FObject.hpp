@@ -1,17 +1,14 @@
 #ifndef FOBJECT_HPP
 #define FOBJECT_HPP
 
+#include "Environment.hpp"
+#include "Object.hpp"
 #include "ast.hpp"
 
-namespace punky::env
-{
-class Environment;
-}
-
 namespace punky::obj
 {
 
-class FunctionObject
+class FunctionObject : public HeapObject
 {
 public:
     FunctionObject(const ast::FunctionLiteral* fn, env::Environment* fn_env) :
@@ -22,16 +19,23 @@ public:
     [[nodiscard]] auto fn() const { return m_fn; }
     [[nodiscard]] auto env() const { return m_fn_env; }
 
+    void trace(gc::Tracer& tracer) const override;
+
 private:
-    // This should be a unique_ptr -> which takes ownership of a FnLit from the AST
+    // Owned by the ast::Arena the literal was parsed into, which outlives the session
     const ast::FunctionLiteral* m_fn;
 
-    // Not sure if a raw ptr here would suffice.
-    // It would suffice for storing out otermost env from main
-    // Apart from that, I'm not sure...
+    // The Environment the literal was evaluated in, kept alive by the function
     env::Environment* m_fn_env;
 };
 
+Object make_function(const ast::FunctionLiteral* fn, env::Environment* fn_env);
+
+// The Environment a call of fn_obj runs in, with args bound to its
+// parameters. One that cannot escape the call is young, and must be
+// released once the call returns.
+env::Environment* extend_fn_env(const FunctionObject& fn_obj, const Object* args);
+
 }  // namespace punky::obj
 
 #endif  // FOBJECT_HPP
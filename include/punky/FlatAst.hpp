@@ -0,0 +1,203 @@
+#ifndef FLATAST_HPP
+#define FLATAST_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Symbol.hpp"
+#include "Token.hpp"
+#include "ast.hpp"
+
+namespace punky::ast
+{
+
+using NodeId = std::uint32_t;
+
+inline constexpr NodeId NO_NODE = std::numeric_limits<NodeId>::max();
+
+// A contiguous run of node ids (or symbols) inside a FlatAst
+class NodeList
+{
+public:
+    NodeList(const std::uint32_t* begin, std::uint32_t size) :
+      m_begin{begin},
+      m_size{size}
+    {}
+
+    [[nodiscard]] const std::uint32_t* begin() const { return m_begin; }
+    [[nodiscard]] const std::uint32_t* end() const { return m_begin + m_size; }
+
+    [[nodiscard]] std::uint32_t size() const { return m_size; }
+    [[nodiscard]] bool          empty() const { return m_size == 0; }
+
+    [[nodiscard]] std::uint32_t operator[](std::uint32_t i) const { return m_begin[i]; }
+    [[nodiscard]] std::uint32_t back() const { return m_begin[m_size - 1]; }
+
+private:
+    const std::uint32_t* m_begin;
+    std::uint32_t        m_size;
+};
+
+// The tree of a Program stored as parallel arrays indexed by NodeId, in the
+// order par::FlatParser recognises the nodes, so a node's children always
+// come before it and a walk touches a few dense vectors instead of chasing
+// pointers. Each node has a kind, an operator token, and three operands
+// whose meaning depends on the kind:
+//
+//   Prog, BlockStmt  a, b = list of statements
+//   ExpressionStmt   a = expression
+//   ReturnStmt       a = expression
+//   LetStmt          a = value, b = symbol
+//   Identifier       a = symbol
+//   Int              a = index of the value in the int literals
+//   Bool             a = value
+//   Prefix           a = operand
+//   Infix            a = left, b = right
+//   If               a = condition, b = consequence, c = alternative or NO_NODE
+//   Call             a = function, b, c = list of arguments
+//   Function         a = body, b, c = list of parameter symbols
+//
+// where a list is a start index and a count into a shared array.
+class FlatAst
+{
+public:
+    [[nodiscard]] NodeId      root() const { return m_root; }
+    [[nodiscard]] std::size_t size() const { return m_kinds.size(); }
+
+    [[nodiscard]] AstType        kind(NodeId node) const { return m_kinds[node]; }
+    [[nodiscard]] tok::TokenType op(NodeId node) const { return m_ops[node]; }
+
+    [[nodiscard]] NodeList statements(NodeId node) const { return list(m_a[node], m_b[node]); }
+
+    [[nodiscard]] NodeId expression(NodeId node) const { return m_a[node]; }
+
+    [[nodiscard]] NodeId        let_value(NodeId node) const { return m_a[node]; }
+    [[nodiscard]] sym::SymbolId let_symbol(NodeId node) const { return m_b[node]; }
+
+    [[nodiscard]] sym::SymbolId symbol(NodeId node) const { return m_a[node]; }
+    [[nodiscard]] std::int64_t  int_value(NodeId node) const { return m_ints[m_a[node]]; }
+    [[nodiscard]] bool          bool_value(NodeId node) const { return m_a[node] != 0; }
+
+    [[nodiscard]] NodeId left(NodeId node) const { return m_a[node]; }
+    [[nodiscard]] NodeId right(NodeId node) const { return m_kinds[node] == AstType::Infix ? m_b[node] : m_a[node]; }
+
+    [[nodiscard]] NodeId condition(NodeId node) const { return m_a[node]; }
+    [[nodiscard]] NodeId consequence(NodeId node) const { return m_b[node]; }
+    [[nodiscard]] NodeId alternative(NodeId node) const { return m_c[node]; }
+
+    [[nodiscard]] NodeId   function(NodeId node) const { return m_a[node]; }
+    [[nodiscard]] NodeList arguments(NodeId node) const { return list(m_b[node], m_c[node]); }
+
+    [[nodiscard]] NodeId   body(NodeId node) const { return m_a[node]; }
+    [[nodiscard]] NodeList params(NodeId node) const { return list(m_b[node], m_c[node]); }
+
+    // Makes room for about the nodes parsed from source_size bytes, so the
+    // columns are not reallocated as they grow
+    void reserve(std::size_t source_size);
+
+    // The same text as the AstNode's to_string(). Only inspect() needs it,
+    // for a function, so it is printed when asked for rather than kept.
+    [[nodiscard]] std::string to_string(NodeId node) const;
+
+private:
+    friend class FlatBuilder;
+
+    std::vector<AstType>        m_kinds;
+    std::vector<tok::TokenType> m_ops;
+    std::vector<std::uint32_t>  m_a;
+    std::vector<std::uint32_t>  m_b;
+    std::vector<std::uint32_t>  m_c;
+
+    std::vector<std::uint32_t> m_lists;
+    std::vector<std::int64_t>  m_ints;
+
+    NodeId m_root{NO_NODE};
+
+    [[nodiscard]] NodeList list(std::uint32_t start, std::uint32_t size) const
+    {
+        return NodeList{m_lists.data() + start, size};
+    }
+
+    auto add_node(AstType kind, tok::TokenType op, std::uint32_t a = 0, std::uint32_t b = 0,
+                  std::uint32_t c = 0) -> NodeId;
+};
+
+// What par::FlatParser builds with: each call appends a node whose children
+// were appended before it. The items of a list are gathered on a stack, as
+// lists nest while they are parsed, and stored together when it ends.
+class FlatBuilder
+{
+public:
+    using Target  = FlatAst;
+    using Program = const FlatAst*;
+    using Expr    = NodeId;
+    using Stmt    = NodeId;
+    using Block   = NodeId;
+
+    // Where a list's items start on the stack, and a stored list
+    using Items = std::size_t;
+    struct List
+    {
+        std::uint32_t m_start;
+        std::uint32_t m_size;
+    };
+    using Params = List;
+    using Args   = List;
+
+    static constexpr Expr  NO_EXPR  = NO_NODE;
+    static constexpr Stmt  NO_STMT  = NO_NODE;
+    static constexpr Block NO_BLOCK = NO_NODE;
+
+    explicit FlatBuilder(FlatAst& ast) :
+      m_ast{&ast}
+    {}
+
+    void reserve(std::size_t source_size);
+
+    auto begin_program() -> Items { return m_items.size(); }
+    auto end_program(Items stmts) -> Program;
+
+    auto begin_block(const tok::Token& /*tok*/) -> Items { return m_items.size(); }
+    auto end_block(Items stmts) -> Block;
+
+    void push_stmt(Items /*stmts*/, Stmt stmt) { m_items.push_back(stmt); }
+
+    auto let(const tok::Token& tok, const tok::Token& name, Expr value) -> Stmt;
+    auto ret(const tok::Token& tok, Expr value) -> Stmt;
+    auto expr_stmt(const tok::Token& tok, Expr expr) -> Stmt;
+
+    auto identifier(const tok::Token& tok) -> Expr;
+    auto int_literal(const tok::Token& tok, std::int64_t value) -> Expr;
+    auto boolean(const tok::Token& tok, bool value) -> Expr;
+    auto prefix(const tok::Token& tok, Expr right) -> Expr;
+    auto infix(const tok::Token& tok, Expr left, Expr right) -> Expr;
+    auto if_expr(const tok::Token& tok, Expr condition, Block consequence,
+                 std::optional<Block> alternative) -> Expr;
+    auto function(const tok::Token& tok, Params params, Block body) -> Expr;
+    auto call(const tok::Token& tok, Expr function, Args args) -> Expr;
+
+    static auto no_params() -> Params { return List{0, 0}; }
+    auto        begin_params() -> Items { return m_items.size(); }
+    void        push_param(Items /*params*/, const tok::Token& param) { m_items.push_back(param.m_symbol); }
+    auto        end_params(Items params) -> Params { return end_list(params); }
+
+    static auto no_args() -> Args { return List{0, 0}; }
+    auto        begin_args() -> Items { return m_items.size(); }
+    void        push_arg(Items /*args*/, Expr arg) { m_items.push_back(arg); }
+    auto        end_args(Items args) -> Args { return end_list(args); }
+
+private:
+    FlatAst* m_ast;
+
+    std::vector<std::uint32_t> m_items;
+
+    auto end_list(Items start) -> List;
+};
+
+}  // namespace punky::ast
+
+#endif  // FLATAST_HPP
@@ -0,0 +1,153 @@
+#ifndef FLATRESOLVER_HPP
+#define FLATRESOLVER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "FlatAst.hpp"
+#include "ScopeNames.hpp"
+#include "Symbol.hpp"
+
+namespace punky::resolve
+{
+
+// Where compiled code finds a name
+enum class Storage : std::uint8_t
+{
+    Global,  // A slot of the VM's globals
+    Local,   // A slot of the running call, which holds a Cell if captured
+    Free,    // A Cell captured by the running closure
+};
+
+struct Binding
+{
+    Storage       m_storage;
+    std::uint32_t m_index;
+};
+
+// A contiguous run of Bindings, see FlatResolver::reads()
+class BindingList
+{
+public:
+    BindingList(const Binding* begin, std::uint32_t size) :
+      m_begin{begin},
+      m_size{size}
+    {}
+
+    [[nodiscard]] const Binding* begin() const { return m_begin; }
+    [[nodiscard]] const Binding* end() const { return m_begin + m_size; }
+
+    [[nodiscard]] std::uint32_t  size() const { return m_size; }
+    [[nodiscard]] const Binding& operator[](std::uint32_t i) const { return m_begin[i]; }
+
+private:
+    const Binding* m_begin;
+    std::uint32_t  m_size;
+};
+
+// How the Compiler lays out the calls of a function literal
+struct FlatFunction
+{
+    std::uint32_t m_num_locals{};
+
+    // By slot, whether a closure made by the call captures it, in which
+    // case the slot holds a Cell both share
+    std::vector<bool> m_cells;
+
+    // For each free variable, where the enclosing call finds its Cell
+    std::vector<Binding> m_captures;
+};
+
+// resolve::Resolver for a FlatAst, by the same ScopeNames rules: a read
+// finds what a lookup by name would at that point of the run, and a
+// function body is resolved once the scope around it is complete. Instead
+// of annotating the nodes, it answers the Compiler's questions about them.
+class FlatResolver
+{
+public:
+    FlatResolver();
+
+    // Globals persist across calls, so a REPL can resolve one FlatAst per
+    // line. What is known about the nodes of the last one is replaced.
+    void resolve(const ast::FlatAst& ast);
+
+    // Where a read of the identifier looks, in order. Every place but the
+    // last may be unbound when it runs, and the last is a global unless the
+    // read cannot run before the local it finds is set.
+    [[nodiscard]] auto reads(ast::NodeId ident) const -> BindingList;
+
+    // Where the let binds its name
+    [[nodiscard]] auto target(ast::NodeId let) const -> const Binding&;
+
+    [[nodiscard]] auto function(ast::NodeId fn) const -> const FlatFunction&;
+
+    // Whether the call is in tail position within a function
+    [[nodiscard]] bool tail(ast::NodeId call) const { return m_tails[call]; }
+
+    // Every global's name, by slot
+    [[nodiscard]] const std::vector<sym::SymbolId>& global_names() const { return m_global_names; }
+
+private:
+    struct Span
+    {
+        std::uint32_t m_start;
+        std::uint32_t m_size;
+    };
+
+    struct Deferred
+    {
+        ast::NodeId m_fn;
+        std::size_t m_position;
+    };
+
+    struct Read
+    {
+        ast::NodeId m_ident;
+        std::size_t m_position;
+    };
+
+    struct Scope : ScopeNames
+    {
+        std::vector<Read>     m_reads;
+        std::vector<Deferred> m_deferred;
+
+        FlatFunction m_fn;
+
+        // The free variable index of each captured (level, slot), as
+        // level << 32 | slot
+        std::unordered_map<std::uint64_t, std::uint32_t> m_free;
+    };
+
+    const ast::FlatAst* m_ast{};
+
+    // The global scope is first, the innermost function last
+    std::vector<Scope> m_scopes;
+
+    std::vector<sym::SymbolId> m_global_names;
+
+    // By NodeId, the reads of an identifier or the target of a let
+    std::vector<Span>    m_spans;
+    std::vector<Binding> m_bindings;
+    std::vector<bool>    m_tails;
+
+    std::unordered_map<ast::NodeId, FlatFunction> m_functions;
+
+    void resolve_statement(ast::NodeId stmt);
+    void resolve_expression(ast::NodeId expr);
+    void resolve_function(const Deferred& deferred);
+    void resolve_deferred();
+
+    void mark_tail_calls(ast::NodeId expr);
+
+    void declare(ast::NodeId let);
+    void lookup(ast::NodeId ident);
+    void bind_read(const Read& read);
+    auto capture(std::size_t level, std::uint32_t slot, std::size_t from) -> std::uint32_t;
+    auto global_slot(sym::SymbolId symbol) -> std::uint32_t;
+};
+
+}  // namespace punky::resolve
+
+#endif  // FLATRESOLVER_HPP
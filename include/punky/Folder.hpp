@@ -0,0 +1,64 @@
+#ifndef FOLDER_HPP
+#define FOLDER_HPP
+
+#include <optional>
+#include <vector>
+
+#include "Arena.hpp"
+#include "FlatAst.hpp"
+#include "Object.hpp"
+#include "ast.hpp"
+
+namespace punky::opt
+{
+
+// Rewrites a parsed Program in place before it runs. Prefix and infix
+// expressions whose operands are constant become literals, and if
+// expressions with a constant condition lose the branch that can never be
+// taken. Values are computed by punky::ops, the same as at run time, and an
+// expression that would produce an error is left alone so that it still
+// fails when, and only if, it is evaluated.
+class Folder
+{
+public:
+    // New literals are allocated in the Arena the Program was parsed into
+    explicit Folder(ast::Arena& arena);
+
+    void fold(ast::Program& prog);
+
+private:
+    ast::Arena* m_arena;
+
+    void fold_block(const ast::StmtNodeVector& stmts);
+    void fold_statement(ast::StmtNode& stmt);
+    void fold_function(ast::FunctionLiteral& fn);
+
+    auto fold_expression(ast::ExprNode* expr) -> ast::ExprNode*;
+    auto fold_prefix(ast::PrefixExpression& expr) -> ast::ExprNode*;
+    auto fold_infix(ast::InfixExpression& expr) -> ast::ExprNode*;
+    auto fold_if(ast::IfExpression& expr) -> ast::ExprNode*;
+
+    auto make_literal(const obj::Object& value) -> ast::ExprNode*;
+};
+
+// What the Folder would do to a FlatAst, which is not rewritten but read by
+// the Compiler: the constant value of each node that has one, and whether a
+// node binds a name in the scope it is in. Both are indexed by NodeId.
+struct FlatFolds
+{
+    std::vector<std::optional<obj::Object>> m_values;
+    std::vector<bool>                       m_declares;
+};
+
+// One pass in NodeId order, as children come before their parents
+auto fold(const ast::FlatAst& ast) -> FlatFolds;
+
+// The branch an if whose condition folds takes, NO_NODE for a missing
+// alternative, by the rule the Folder drops the other one by. None if the
+// condition does not fold or the other branch binds a name.
+auto live_branch(const ast::FlatAst& ast, const FlatFolds& folds, ast::NodeId if_expr)
+  -> std::optional<ast::NodeId>;
+
+}  // namespace punky::opt
+
+#endif  // FOLDER_HPP
@@ -0,0 +1,259 @@
+#ifndef HEAP_HPP
+#define HEAP_HPP
+
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <cstddef>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Object.hpp"
+
+namespace punky::gc
+{
+
+// Collects the HeapObjects reachable from the roots during a collection
+class Tracer
+{
+public:
+    void mark(const obj::Object& obj)
+    {
+        if (obj.is_heap())
+            mark(obj.heap_object());
+    }
+
+    void mark(const obj::HeapObject* obj);
+
+private:
+    friend class Heap;
+
+    std::vector<const obj::HeapObject*> m_gray;
+};
+
+// Something outside the heap that holds Objects: a VM's stack and globals,
+// a compiler's constants. It is registered with Heap::add_roots() and is
+// asked for its Objects at every collection.
+class RootSet
+{
+public:
+    RootSet()                     = default;
+    RootSet(RootSet const& other) = delete;
+    RootSet& operator=(RootSet const& other) = delete;
+    RootSet(RootSet&& other)                 = delete;
+    RootSet& operator=(RootSet&& other) = delete;
+    virtual ~RootSet()                  = default;
+
+    virtual void trace(Tracer& tracer) const = 0;
+};
+
+// Keeps a value alive for as long as the Root is in scope, for values held
+// in C++ locals across a safepoint, like the left operand of an infix
+// expression while its right operand calls a function.
+class Root : public RootSet
+{
+public:
+    explicit Root(const obj::Object& obj);
+    explicit Root(const obj::HeapObject* obj);
+
+    // Follows the vector as it grows
+    explicit Root(const std::vector<obj::Object>& objs);
+
+    Root(Root const& other) = delete;
+    Root& operator=(Root const& other) = delete;
+    Root(Root&& other)                 = delete;
+    Root& operator=(Root&& other) = delete;
+    ~Root() override;
+
+    void trace(Tracer& tracer) const override;
+
+private:
+    const obj::HeapObject*          m_obj{};
+    const std::vector<obj::Object>* m_objs{};
+};
+
+struct HeapStats
+{
+    std::size_t m_collections{};
+
+    std::size_t m_live_bytes{};
+    std::size_t m_live_objects{};
+    std::size_t m_pages{};
+
+    std::size_t m_allocated_bytes{};  // Since the heap was created
+    std::size_t m_freed_bytes{};
+    std::size_t m_young_bytes{};
+
+    std::size_t m_allocated_objects{};  // Since the heap was created
+    std::size_t m_young_objects{};
+
+    std::chrono::nanoseconds m_last_pause{};
+    std::chrono::nanoseconds m_max_pause{};
+    std::chrono::nanoseconds m_total_pause{};
+};
+
+std::string to_string(const HeapStats& stats);
+
+// A mark-and-sweep collector for every HeapObject. Small objects are carved
+// out of pages of equally sized cells, one list of pages per size class;
+// larger ones get an allocation of their own.
+//
+// Objects that are known to die in LIFO order, like the Environment of a
+// call that no closure can capture, can instead be allocated young: bumped
+// off the top of the nursery and freed in bulk by release_young(), without
+// ever being swept. Everything in the nursery is a root, and nothing else
+// may point into it but C++ locals and other young objects.
+//
+// Collections only happen at safepoints, where every live value is reachable
+// from a RootSet: the evaluator and the VM call safepoint() as they enter a
+// function. Allocating never collects, so code between safepoints can hold
+// Objects in locals freely.
+class Heap
+{
+public:
+    Heap() = default;
+    Heap(Heap const& other) = delete;
+    Heap& operator=(Heap const& other) = delete;
+    Heap(Heap&& other)                 = delete;
+    Heap& operator=(Heap&& other) = delete;
+    ~Heap();
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args)
+    {
+        static_assert(std::is_base_of_v<obj::HeapObject, T>);
+        static_assert(alignof(T) <= CELL_ALIGN);
+
+        auto* obj = new (allocate(sizeof(T))) T(std::forward<Args>(args)...);
+        commit(obj, sizeof(T));
+        return obj;
+    }
+
+    // As make(), with extra bytes after the object for it to use, in the
+    // nursery. Returns nullptr if that does not fit in a nursery chunk.
+    template <typename T, typename... Args>
+    T* make_young(std::size_t extra, Args&&... args)
+    {
+        static_assert(std::is_base_of_v<obj::HeapObject, T>);
+        static_assert(alignof(T) <= CELL_ALIGN);
+
+        auto* memory = allocate_young(sizeof(T) + extra);
+        if (!memory)
+            return nullptr;
+
+        auto* obj = new (memory) T(std::forward<Args>(args)...);
+        commit_young(obj);
+        return obj;
+    }
+
+    // Destroys obj, which must be young, and everything made young after it
+    void release_young(obj::HeapObject* obj);
+
+    void safepoint()
+    {
+        if (m_allocated_since_gc >= m_next_gc)
+            collect();
+    }
+
+    void collect();
+
+    void add_roots(const RootSet& roots);
+    void remove_roots(const RootSet& roots);
+
+    // Bytes allocated between collections. Once a collection is over, the
+    // next waits for at least as many bytes as survived it, so the cost of
+    // collecting stays proportional to allocation. A threshold of 0
+    // collects at every safepoint, which finds values missing a Root.
+    void set_threshold(std::size_t bytes);
+
+    [[nodiscard]] const HeapStats& stats() const { return m_stats; }
+
+private:
+    static constexpr std::size_t PAGE_SIZE  = 64 * 1024;
+    static constexpr std::size_t CELL_ALIGN = 16;
+
+    static constexpr std::array<std::size_t, 8> SIZE_CLASSES{16, 32, 48, 64, 96, 128, 192, 256};
+    static constexpr std::size_t                MAX_CELL_SIZE = SIZE_CLASSES.back();
+    static constexpr std::size_t                MAX_CELLS     = PAGE_SIZE / CELL_ALIGN;
+
+    // Sits at the start of its PAGE_SIZE aligned page, so any cell finds it
+    // by masking its own address.
+    struct Page
+    {
+        std::size_t            m_cell_size;
+        std::size_t            m_num_cells;
+        std::bitset<MAX_CELLS> m_used;
+
+        auto cell(std::size_t index) -> std::byte*;
+    };
+
+    static constexpr std::size_t PAGE_HEADER_SIZE = (sizeof(Page) + CELL_ALIGN - 1) / CELL_ALIGN * CELL_ALIGN;
+
+    struct FreeCell
+    {
+        FreeCell* m_next;
+    };
+
+    struct SizeClass
+    {
+        std::vector<Page*> m_pages;
+        FreeCell*          m_free{};
+    };
+
+    struct LargeObject
+    {
+        obj::HeapObject* m_obj;
+        std::size_t      m_size;
+    };
+
+    static constexpr std::size_t YOUNG_CHUNK_SIZE = 256 * 1024;
+
+    struct YoungObject
+    {
+        obj::HeapObject* m_obj;
+        std::size_t      m_chunk;
+    };
+
+    std::array<SizeClass, SIZE_CLASSES.size()> m_classes{};
+    std::vector<LargeObject>                   m_large;
+
+    // Chunks stay allocated once the nursery shrinks back out of them
+    std::vector<std::byte*>  m_young_chunks;
+    std::vector<YoungObject> m_young;
+    std::size_t              m_young_chunk{};
+    std::byte*               m_young_top{};
+    std::byte*               m_young_end{};
+
+    std::vector<const RootSet*> m_roots;
+    Tracer                      m_tracer;
+
+    std::size_t m_threshold{4 * 1024 * 1024};
+    std::size_t m_next_gc{m_threshold};
+    std::size_t m_allocated_since_gc{};
+
+    HeapStats m_stats;
+
+    auto allocate(std::size_t size) -> void*;
+    void commit(obj::HeapObject* obj, std::size_t size);
+
+    auto allocate_young(std::size_t size) -> void*;
+    void commit_young(obj::HeapObject* obj);
+
+    void add_page(std::size_t size_class);
+    void mark();
+    void sweep();
+    void sweep_class(std::size_t size_class);
+
+    static auto size_class(std::size_t size) -> std::size_t;
+    static auto page_of(const void* cell) -> Page*;
+};
+
+// The heap every Object is allocated in
+auto heap() -> Heap&;
+
+}  // namespace punky::gc
+
+#endif  // HEAP_HPP
@@ -1,9 +1,9 @@
 #ifndef LEXER_HPP
 #define LEXER_HPP
 
+#include <cstddef>
 #include <optional>
-#include <string>
-#include <unordered_map>
+#include <string_view>
 
 #include "Token.hpp"
 
@@ -15,25 +15,30 @@ using punky::tok::Token;
 class Lexer
 {
 public:
-    explicit Lexer(std::string line);
+    // Tokens point into source, which must outlive them and anything parsed
+    // from them; see ast::Arena::copy_source().
+    explicit Lexer(std::string_view source);
 
     Token next_token();
 
+    [[nodiscard]] std::size_t source_size() const { return m_source.size(); }
+
 private:
-    std::string                 m_line;
-    std::string::const_iterator m_curr_it;
-    char                        m_curr_char;
+    std::string_view m_source;
+    std::size_t      m_curr_pos{};
+    char             m_curr_char;
 
     [[nodiscard]] bool next_eof() const;
 
     [[nodiscard]] auto peek() const -> std::optional<char>;
 
     void consume();
+    void seek(std::size_t pos);
 
     void skip_whitespace();
 
-    std::string tokenize_identifier();
-    std::string tokenize_integer();
+    std::string_view tokenize_identifier();
+    std::string_view tokenize_integer();
 };
 }  // namespace punky::lex
 
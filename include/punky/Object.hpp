@@ -1,39 +1,141 @@
 #ifndef OBJECT_HPP
 #define OBJECT_HPP
 
-#include <any>
+#include <cstdint>
 #include <string>
-#include <variant>
+#include <type_traits>
+#include <utility>
 
-#include "FObject.hpp"
+namespace punky::gc
+{
+class Heap;
+class Tracer;
+}  // namespace punky::gc
 
 namespace punky::obj
 {
 
-enum class ObjectType
+// Heap-backed types are kept contiguous at the end, see Object::is_heap()
+enum class ObjectType : std::uint8_t
 {
     Null,
     Int,
     Boolean,
-    Return,
+    EmptyOut,
+    Unbound,  // A VM slot whose name is not bound yet, never a value
     Error,
     Function,
-    EmptyOut
+    Closure,
+    Cell,
+};
+
+// Base of every heap-allocated payload. HeapObjects are allocated in, and
+// owned by, gc::heap(), which frees them once no root reaches them.
+class HeapObject
+{
+public:
+    HeapObject()                        = default;
+    HeapObject(HeapObject const& other) = delete;
+    HeapObject& operator=(HeapObject const& other) = delete;
+    HeapObject(HeapObject&& other)                 = delete;
+    HeapObject& operator=(HeapObject&& other) = delete;
+    virtual ~HeapObject()                     = default;
+
+    // Marks every Object and HeapObject this one refers to
+    virtual void trace(gc::Tracer& /*tracer*/) const {}
+
+    // Allocated in the nursery by gc::Heap::make_young()
+    [[nodiscard]] bool is_young() const { return m_young; }
+
+private:
+    friend class gc::Heap;
+    friend class gc::Tracer;
+
+    mutable bool m_marked{};
+    bool         m_young{};
+};
+
+// A 16 byte tagged value: ints, booleans, null and the empty output are
+// stored inline, everything else is a pointer to a HeapObject. Copying one
+// is a plain copy; the collector keeps what it points to alive.
+class Object
+{
+public:
+    Object() = default;
+
+    explicit Object(ObjectType type) :
+      m_type{type}
+    {}
+
+    explicit Object(std::int64_t value) :
+      m_type{ObjectType::Int}
+    {
+        m_payload.m_int = value;
+    }
+
+    explicit Object(bool value) :
+      m_type{ObjectType::Boolean}
+    {
+        m_payload.m_bool = value;
+    }
+
+    Object(ObjectType type, HeapObject* heap) :
+      m_type{type}
+    {
+        m_payload.m_heap = heap;
+    }
+
+    [[nodiscard]] ObjectType type() const { return m_type; }
+
+    [[nodiscard]] bool is_heap() const { return m_type >= ObjectType::Error; }
+
+    // Set while the value of a return statement unwinds to its function
+    // boundary. It lives in padding, so signalling a return never allocates.
+    [[nodiscard]] bool returning() const { return m_returning; }
+    void               set_returning(bool returning) { m_returning = returning; }
+
+    [[nodiscard]] std::int64_t as_int() const { return m_payload.m_int; }
+    [[nodiscard]] bool         as_bool() const { return m_payload.m_bool; }
+
+    [[nodiscard]] HeapObject* heap_object() const { return m_payload.m_heap; }
+
+    template <typename T>
+    [[nodiscard]] const T& as() const
+    {
+        return *static_cast<const T*>(m_payload.m_heap);
+    }
+
+private:
+    union Payload
+    {
+        std::int64_t m_int;
+        bool         m_bool;
+        HeapObject*  m_heap;
+    };
+
+    ObjectType m_type{ObjectType::Null};
+    bool       m_returning{};
+    Payload    m_payload{};
 };
 
-using ValVariant = std::variant<std::monostate,
-                                int,
-                                bool,
-                                std::any,
-                                std::string,
-                                FunctionObject>;
+static_assert(sizeof(Object) == 16);
+static_assert(std::is_trivially_copyable_v<Object>);
 
-struct Object
+class ErrorObject : public HeapObject
 {
-    ObjectType m_type;
-    ValVariant m_value;
+public:
+    explicit ErrorObject(std::string message) :
+      m_message{std::move(message)}
+    {}
+
+    [[nodiscard]] const std::string& message() const { return m_message; }
+
+private:
+    std::string m_message;
 };
 
+Object make_error(std::string message);
+
 std::string inspect(const Object& obj);
 
 std::string type_to_string(const ObjectType& type);
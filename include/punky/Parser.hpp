@@ -1,13 +1,16 @@
 #ifndef PARSER_HPP
 #define PARSER_HPP
 
-#include <functional>
-#include <memory>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <string>
-#include <unordered_map>
 #include <variant>
 #include <vector>
 
+#include "Arena.hpp"
+#include "FlatAst.hpp"
 #include "Parser_detail.hpp"
 
 namespace punky::par
@@ -17,50 +20,128 @@ using punky::lex::Lexer;
 using punky::tok::Token;
 using punky::tok::TokenType;
 
-class Parser
+// What Parser builds with: the linked tree, allocated in an Arena. Every
+// Builder offers the same calls, one per kind of node, so the grammar is
+// written once for each representation.
+class TreeBuilder
 {
 public:
-    explicit Parser(Lexer lex);
+    using Target  = ast::Arena;
+    using Program = ast::Program*;
+    using Expr    = ast::ExprNode*;
+    using Stmt    = ast::StmtNode*;
+    using Block   = ast::BlockStmt*;
+    using Params  = ast::OptFnParams;
+    using Args    = ast::OptCallArgs;
+
+    static constexpr Expr  NO_EXPR  = nullptr;
+    static constexpr Stmt  NO_STMT  = nullptr;
+    static constexpr Block NO_BLOCK = nullptr;
+
+    explicit TreeBuilder(ast::Arena& arena) :
+      m_arena{&arena}
+    {}
+
+    // Arena blocks hold many nodes each already
+    void reserve(std::size_t /*source_size*/) {}
+
+    auto begin_program() -> Program { return m_arena->make<ast::Program>(); }
+    auto end_program(Program prog) -> Program { return prog; }
+
+    auto begin_block(const Token& tok) -> Block { return m_arena->make<ast::BlockStmt>(tok); }
+    auto end_block(Block blk) -> Block { return blk; }
+
+    template <typename Stmts>
+    void push_stmt(Stmts* stmts, Stmt stmt)
+    {
+        stmts->push_stmt(stmt);
+    }
+
+    auto let(const Token& tok, const Token& name, Expr value) -> Stmt;
+    auto ret(const Token& tok, Expr value) -> Stmt;
+    auto expr_stmt(const Token& tok, Expr expr) -> Stmt;
+
+    auto identifier(const Token& tok) -> Expr;
+    auto int_literal(const Token& tok, std::int64_t value) -> Expr;
+    auto boolean(const Token& tok, bool value) -> Expr;
+    auto prefix(const Token& tok, Expr right) -> Expr;
+    auto infix(const Token& tok, Expr left, Expr right) -> Expr;
+    auto if_expr(const Token& tok, Expr condition, Block consequence,
+                 std::optional<Block> alternative) -> Expr;
+    auto function(const Token& tok, Params params, Block body) -> Expr;
+    auto call(const Token& tok, Expr function, Args args) -> Expr;
+
+    static auto no_params() -> Params { return std::nullopt; }
+    static auto begin_params() -> std::vector<ast::Identifier> { return {}; }
+    static void push_param(std::vector<ast::Identifier>& params, const Token& param) { params.emplace_back(param); }
+    auto        end_params(std::vector<ast::Identifier>& params) -> Params;
+
+    static auto no_args() -> Args { return std::nullopt; }
+    static auto begin_args() -> ast::ExprNodeVector { return {}; }
+    static void push_arg(ast::ExprNodeVector& args, Expr arg) { args.push_back(arg); }
+    auto        end_args(ast::ExprNodeVector& args) -> Args;
 
-    auto parse_program() -> std::variant<bool, std::unique_ptr<ast::Program>>;
+private:
+    ast::Arena* m_arena;
+};
+
+template <typename Builder>
+class BasicParser
+{
+public:
+    using Program = typename Builder::Program;
+
+    // Nodes are built into target, which must outlive the parsed Program
+    BasicParser(Lexer lex, typename Builder::Target& target);
+
+    auto parse_program() -> std::variant<bool, Program>;
 
 private:
-    using PrefixParseFn = std::function<ast::ExprNodePtr()>;
-    using InfixParseFn  = std::function<ast::ExprNodePtr(ast::ExprNodePtr)>;
+    using Expr   = typename Builder::Expr;
+    using Stmt   = typename Builder::Stmt;
+    using Block  = typename Builder::Block;
+    using Params = typename Builder::Params;
+    using Args   = typename Builder::Args;
 
-    Lexer m_lex;
-    Token m_curr_tok;
-    Token m_peek_tok;
+    using PrefixParseFn = Expr (BasicParser::*)();
+    using InfixParseFn  = Expr (BasicParser::*)(Expr);
 
-    std::vector<std::string> m_errors;
+    // Pratt dispatch tables indexed by TokenType, shared by every Parser.
+    // An empty entry means the token cannot start or continue an expression.
+    static const std::array<PrefixParseFn, tok::NUM_TOKEN_TYPES> M_PREFIX_PARSE_FNS;
+    static const std::array<InfixParseFn, tok::NUM_TOKEN_TYPES>  M_INFIX_PARSE_FNS;
+
+    Lexer   m_lex;
+    Builder m_build;
+    Token   m_curr_tok;
+    Token   m_peek_tok;
 
-    std::unordered_map<TokenType, PrefixParseFn> m_prefix_parse_fns;
-    std::unordered_map<TokenType, InfixParseFn>  m_infix_parse_fns;
+    std::vector<std::string> m_errors;
 
     void consume();
 
-    auto parse_statement() -> std::unique_ptr<ast::StmtNode>;
-    auto parse_let_statement() -> std::unique_ptr<ast::LetStmt>;
-    auto parse_return_statement() -> std::unique_ptr<ast::ReturnStmt>;
-    auto parse_expression_statement() -> std::unique_ptr<ast::ExpressionStmt>;
-    auto parse_block_statement() -> std::unique_ptr<ast::BlockStmt>;
+    auto parse_statement() -> Stmt;
+    auto parse_let_statement() -> Stmt;
+    auto parse_return_statement() -> Stmt;
+    auto parse_expression_statement() -> Stmt;
+    auto parse_block_statement() -> Block;
 
-    auto parse_expression(PrecedenceLevel precedence) -> ast::ExprNodePtr;
+    auto parse_expression(PrecedenceLevel precedence) -> Expr;
 
-    auto parse_prefix_expression() -> ast::ExprNodePtr;
-    auto parse_infix_expression(ast::ExprNodePtr left_expr) -> ast::ExprNodePtr;
+    auto parse_prefix_expression() -> Expr;
+    auto parse_infix_expression(Expr left_expr) -> Expr;
 
-    auto parse_identifier() -> ast::ExprNodePtr;
-    auto parse_int_literal() -> ast::ExprNodePtr;
-    auto parse_boolean() -> ast::ExprNodePtr;
-    auto parse_grouped_expression() -> ast::ExprNodePtr;
-    auto parse_if_expression() -> ast::ExprNodePtr;
+    auto parse_identifier() -> Expr;
+    auto parse_int_literal() -> Expr;
+    auto parse_boolean() -> Expr;
+    auto parse_grouped_expression() -> Expr;
+    auto parse_if_expression() -> Expr;
 
-    auto parse_function_literal() -> ast::ExprNodePtr;
-    auto parse_function_params() -> ast::OptFnParams;
+    auto parse_function_literal() -> Expr;
+    auto parse_function_params() -> Params;
 
-    auto parse_call_expression(ast::ExprNodePtr function) -> ast::ExprNodePtr;
-    auto parse_call_arguments() -> ast::OptCallArgs;
+    auto parse_call_expression(Expr function) -> Expr;
+    auto parse_call_arguments() -> Args;
 
     [[nodiscard]] bool curr_type_is(const TokenType& type) const;
     [[nodiscard]] bool peek_type_is(const TokenType& type) const;
@@ -69,15 +150,22 @@ private:
 
     void peek_error(const TokenType& type);
 
-    void register_prefix(TokenType type, PrefixParseFn pre_parse_fn);
-    void register_infix(TokenType type, InfixParseFn in_parse_fn);
-
     [[nodiscard]] auto curr_precedence() const -> PrecedenceLevel;
     [[nodiscard]] auto peek_precedence() const -> PrecedenceLevel;
 
-    auto parse_fn_error(TokenType tok_type, ParseFnType parse_type) -> ast::ExprNodePtr;
+    auto parse_fn_error(TokenType tok_type, ParseFnType parse_type) -> Expr;
 };
 
+// Parses into the linked tree the Resolver, the Evaluator and the thunk
+// engine work on
+using Parser = BasicParser<TreeBuilder>;
+
+// Parses straight into an ast::FlatAst, for the Compiler
+using FlatParser = BasicParser<ast::FlatBuilder>;
+
+extern template class BasicParser<TreeBuilder>;
+extern template class BasicParser<ast::FlatBuilder>;
+
 }  // namespace punky::par
 
 #endif  // PARSER_HPP
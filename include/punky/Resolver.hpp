@@ -0,0 +1,74 @@
+#ifndef RESOLVER_HPP
+#define RESOLVER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "ScopeNames.hpp"
+#include "Symbol.hpp"
+#include "ast.hpp"
+
+namespace punky::resolve
+{
+
+// Assigns every identifier the Evaluator reads or binds a lexical address
+// (depth, slot), and every function literal the number of slots its calls
+// need and whether their Environments can escape. Calls in tail position
+// within a function are marked as such. Names that are not bound in any
+// enclosing scope become globals.
+//
+// A read finds what a lookup by name would at that point of the run: the
+// innermost scope whose binding of the name has been set. A read that may
+// run before its slot is set gets a fallback, see ast::Identifier.
+class Resolver
+{
+public:
+    Resolver();
+
+    // Globals persist across calls, so a REPL can resolve one Program per line.
+    void resolve(const ast::Program& prog);
+
+private:
+    struct Deferred
+    {
+        const ast::FunctionLiteral* m_fn;
+        std::size_t                 m_position;
+    };
+
+    struct Read
+    {
+        const ast::Identifier* m_ident;
+        std::size_t            m_position;
+    };
+
+    struct Scope : ScopeNames
+    {
+        // Reads are bound, and function bodies resolved, once the scope is
+        // complete, so they also see names its later lets bind.
+        std::vector<Read>     m_reads;
+        std::vector<Deferred> m_deferred;
+    };
+
+    // The global scope is first, the innermost function last
+    std::vector<Scope> m_scopes;
+
+    // The fallbacks bound to reads, which live as long as the Resolver
+    std::deque<ast::Identifier> m_fallbacks;
+
+    void resolve_block(const ast::StmtNodeVector& stmts);
+    void resolve_statement(const ast::StmtNode& stmt);
+    void resolve_expression(const ast::ExprNode& expr);
+    void resolve_function(const Deferred& deferred);
+    void resolve_deferred();
+
+    void declare(const ast::Identifier& ident);
+    void lookup(const ast::Identifier& ident);
+    void bind_read(const Read& read);
+    auto global_slot(sym::SymbolId symbol) -> std::uint32_t;
+};
+
+}  // namespace punky::resolve
+
+#endif  // RESOLVER_HPP
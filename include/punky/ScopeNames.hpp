@@ -0,0 +1,101 @@
+#ifndef SCOPENAMES_HPP
+#define SCOPENAMES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Symbol.hpp"
+#include "ast.hpp"
+
+namespace punky::resolve
+{
+
+// The rules Resolver and FlatResolver share: which slot a name gets, from
+// which statement on a read may count on it, and which calls are in tail
+// position. Each keeps one ScopeNames per scope, the global one first.
+struct ScopeNames
+{
+    std::unordered_map<sym::SymbolId, std::uint32_t> m_slots;
+    std::uint32_t                                    m_num_slots{};
+
+    // Statements of the function body are numbered in order. A name is
+    // bound from the statement after the first let of it at the top of
+    // the body, while a let in an if only may be.
+    std::unordered_map<sym::SymbolId, std::size_t> m_bound_from;
+    std::size_t                                    m_position{};
+
+    // Where in the enclosing body this function's literal is
+    std::size_t m_entry_position{};
+
+    // The slot of a let's name, and whether it is a new one. Redefining a
+    // name rebinds the same slot.
+    auto declare(sym::SymbolId symbol) -> std::pair<std::uint32_t, bool>;
+
+    // The arguments of a call are its first slots, one each, so a repeated
+    // parameter name refers to the last of them as in the Evaluator
+    auto declare_param(sym::SymbolId symbol) -> std::uint32_t;
+
+    // Steps past a statement at the top of the body, which binds let if it
+    // is a let statement
+    void end_statement(std::optional<sym::SymbolId> let);
+};
+
+// Calls found(level, slot) for each scope a read of symbol at position in
+// the innermost scope looks in, innermost first, until one whose binding
+// is set by then. Returns false if there is none, in which case the read
+// falls back to the global of the name last.
+template <typename Scope, typename Found>
+bool find_bindings(const std::vector<Scope>& scopes, sym::SymbolId symbol, std::size_t position,
+                   Found found)
+{
+    for (auto level = scopes.size() - 1; level > 0; --level)
+    {
+        const ScopeNames& scope = scopes[level];
+        if (const auto res = scope.m_slots.find(symbol); res != scope.m_slots.cend())
+        {
+            found(level, res->second);
+
+            const auto bound = scope.m_bound_from.find(symbol);
+            if (bound != scope.m_bound_from.cend() && bound->second <= position)
+                return true;
+        }
+        position = scope.m_entry_position;
+    }
+    return false;
+}
+
+// Calls tail(call) for each call in tail position within expr, which is in
+// tail position itself: expr, or the last expression of a branch of an if.
+// A function's body is in tail position, and so is what a return in it
+// returns. View gives kind(), consequence(), alternative() and
+// last_expression() of a block, which is empty for a missing one.
+template <typename View, typename Tail>
+void mark_tail(const View& view, typename View::Expr expr, Tail tail)
+{
+    switch (view.kind(expr))
+    {
+        case ast::AstType::Call:
+            tail(expr);
+            break;
+
+        case ast::AstType::If:
+            for (const auto block : {view.consequence(expr), view.alternative(expr)})
+            {
+                if (const auto last = view.last_expression(block); last)
+                    mark_tail(view, *last, tail);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+}  // namespace punky::resolve
+
+#endif  // SCOPENAMES_HPP
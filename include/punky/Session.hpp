@@ -0,0 +1,67 @@
+#ifndef SESSION_HPP
+#define SESSION_HPP
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+#include "Arena.hpp"
+#include "Compiler.hpp"
+#include "Environment.hpp"
+#include "Folder.hpp"
+#include "Heap.hpp"
+#include "Object.hpp"
+#include "Resolver.hpp"
+#include "ThunkCompiler.hpp"
+#include "VM.hpp"
+#include "operators.hpp"
+
+namespace punky::repl
+{
+
+enum class Engine
+{
+    Evaluator,
+    Thunks,
+    VM,
+};
+
+// Everything one REPL, or one script, runs against. Each chunk of input is
+// parsed into the session's Arena, which outlives it, so a function defined
+// by one chunk is still valid, and not parsed again, when a later chunk
+// calls it. Globals live in the Environment or the VM, whichever engine the
+// session runs on.
+class Session
+{
+public:
+    // Calls nested deeper than max_depth fail with a stack overflow Error
+    explicit Session(Engine engine, std::size_t max_depth = ops::DEFAULT_MAX_DEPTH);
+
+    // Runs source, which must outlive the Session, as the next chunk of the
+    // program. Returns nullopt if it did not parse.
+    auto run(std::string_view source) -> std::optional<obj::Object>;
+
+    // As run(), for input that does not outlive the call, like a line buffer
+    auto run_line(std::string_view line) -> std::optional<obj::Object>;
+
+private:
+    Engine      m_engine;
+    std::size_t m_max_depth;
+
+    ast::Arena m_arena;
+
+    opt::Folder       m_folder;
+    resolve::Resolver m_resolver;
+    env::Environment* m_env;
+    gc::Root          m_env_root;
+
+    thunk::ThunkCompiler m_thunks;
+    compile::Compiler    m_compiler;
+    vm::VM               m_vm;
+
+    auto run_compiled(std::string_view source) -> std::optional<obj::Object>;
+};
+
+}  // namespace punky::repl
+
+#endif  // SESSION_HPP
@@ -0,0 +1,44 @@
+#ifndef SOURCEFILE_HPP
+#define SOURCEFILE_HPP
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace punky::io
+{
+
+// The whole text of a script, read once. Regular files are mapped instead
+// of copied, so a large script costs no more than the pages the Lexer
+// touches; pipes and stdin are read into a buffer.
+class SourceFile
+{
+public:
+    SourceFile(SourceFile const& other) = delete;
+    SourceFile& operator=(SourceFile const& other) = delete;
+    SourceFile(SourceFile&& other) noexcept;
+    SourceFile& operator=(SourceFile&& other) noexcept;
+    ~SourceFile();
+
+    // "-" reads stdin. Returns nullopt, with errno set, if path can't be read.
+    static auto open(const std::string& path) -> std::optional<SourceFile>;
+
+    // Valid for the lifetime of the SourceFile, so it can be lexed directly
+    [[nodiscard]] std::string_view text() const { return m_text; }
+
+private:
+    SourceFile() = default;
+
+    void*       m_mapping{};
+    std::size_t m_mapped_size{};
+    std::string m_buffer;
+
+    std::string_view m_text;
+
+    void unmap();
+};
+
+}  // namespace punky::io
+
+#endif  // SOURCEFILE_HPP
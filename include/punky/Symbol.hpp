@@ -0,0 +1,38 @@
+#ifndef SYMBOL_HPP
+#define SYMBOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace punky::sym
+{
+
+using SymbolId = std::uint32_t;
+
+// Interns every name once, so later passes compare and hash names as integers
+class SymbolTable
+{
+public:
+    auto intern(std::string_view name) -> SymbolId;
+
+    [[nodiscard]] auto name(SymbolId id) const -> std::string_view { return m_names[id]; }
+
+    [[nodiscard]] std::size_t size() const { return m_names.size(); }
+
+private:
+    // A deque never moves its elements, so the views in m_ids stay valid
+    std::deque<std::string>                        m_names;
+    std::unordered_map<std::string_view, SymbolId> m_ids;
+};
+
+// The table shared by every Lexer, so a name gets the same SymbolId on
+// every REPL line and in both engines.
+auto symbols() -> SymbolTable&;
+
+}  // namespace punky::sym
+
+#endif  // SYMBOL_HPP
@@ -0,0 +1,81 @@
+#ifndef THUNKCOMPILER_HPP
+#define THUNKCOMPILER_HPP
+
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "CallStack.hpp"
+#include "Environment.hpp"
+#include "Heap.hpp"
+#include "Object.hpp"
+#include "ast.hpp"
+#include "operators.hpp"
+
+namespace punky::thunk
+{
+
+using punky::obj::Object;
+
+// One AST node, already specialised for its kind, operator and children
+using Thunk = std::function<Object(env::Environment&)>;
+
+// The closure-compiling engine, between the Evaluator and the VM: each node
+// of a resolved Program is turned once into a Thunk that calls its children's
+// Thunks directly, so running it never switches on an AstType or TokenType.
+// The semantics, errors included, are the Evaluator's.
+//
+// Function bodies are compiled the first time their literal is, and stay
+// valid as long as the ThunkCompiler and the Arena the literal lives in.
+class ThunkCompiler
+{
+public:
+    explicit ThunkCompiler(std::size_t max_depth = ops::DEFAULT_MAX_DEPTH);
+
+    // prog must have been through resolve::Resolver
+    [[nodiscard]] auto compile(const ast::Program& prog) -> Thunk;
+
+private:
+    // Each call site remembers the last function it called, so a monomorphic
+    // site finds the body without hashing the literal.
+    struct BodyCache
+    {
+        const ast::FunctionLiteral* m_fn_lit{};
+        const Thunk*                m_body{};
+    };
+
+    eval::CallStack m_calls;
+
+    // Where global identifiers are read, the Environment a Program runs in
+    const env::Environment* m_globals{};
+
+    // The callee and arguments of every call being set up, so they are
+    // rooted until bound in the callee's Environment.
+    std::vector<Object> m_args;
+    gc::Root            m_args_root{m_args};
+
+    // Left by a call in tail position for the apply() of the enclosing call
+    const Thunk* m_tail_body{};
+    std::size_t  m_tail_base{};
+
+    std::unordered_map<const ast::FunctionLiteral*, Thunk> m_bodies;
+
+    auto compile_node(const ast::AstNode& node) -> Thunk;
+    auto compile_block(const ast::BlockStmt& block) -> Thunk;
+    auto compile_global(const ast::Identifier& ident) -> Thunk;
+    auto compile_fallback(const ast::Identifier& ident) -> Thunk;
+    auto compile_infix(const ast::InfixExpression& infix) -> Thunk;
+    auto compile_if(const ast::IfExpression& if_expr) -> Thunk;
+    auto compile_call(const ast::CallExpression& call) -> Thunk;
+
+    auto body(const ast::FunctionLiteral* fn_lit) -> const Thunk&;
+    auto body(const Object& fn, BodyCache& cache) -> const Thunk*;
+
+    // Calls the function at m_args[base] with the arguments above it
+    Object apply(std::size_t base, const Thunk* body);
+};
+
+}  // namespace punky::thunk
+
+#endif  // THUNKCOMPILER_HPP
@@ -1,9 +1,12 @@
 #ifndef TOKEN_HPP
 #define TOKEN_HPP
 
+#include <cstddef>
 #include <optional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+
+#include "Symbol.hpp"
 
 namespace punky::tok
 {
@@ -40,15 +43,20 @@ enum class TokenType
 };
 // clang-format on
 
-using TokenLiteral = std::optional<std::string>;
+inline constexpr std::size_t NUM_TOKEN_TYPES = static_cast<std::size_t>(TokenType::EOS) + 1;
+
+// A view into the source buffer the Lexer was given, so Tokens are cheap to
+// copy and lexing does not allocate. The buffer must outlive the Token.
+using TokenLiteral = std::optional<std::string_view>;
 
 struct Token
 {
-    TokenType    m_type{};
-    TokenLiteral m_literal;
+    TokenType     m_type{};
+    TokenLiteral  m_literal;
+    sym::SymbolId m_symbol{};  // Only meaningful for identifiers
 };
 
-auto make_token(TokenType type, TokenLiteral literal) -> Token;
+auto make_token(TokenType type, TokenLiteral literal, sym::SymbolId symbol = {}) -> Token;
 
 std::string type_to_string(const TokenType& type);
 
@@ -0,0 +1,78 @@
+#ifndef VM_HPP
+#define VM_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "Code.hpp"
+#include "Compiler.hpp"
+#include "Heap.hpp"
+#include "Object.hpp"
+#include "Symbol.hpp"
+#include "operators.hpp"
+
+namespace punky::vm
+{
+
+using punky::obj::Object;
+
+// How often each opcode ran right after each other one, by the two opcodes.
+// Only counted when built with PUNKY_VM_PROFILE, by every VM into the one
+// opcode_pairs(); punky_bench --opcode-pairs reports it, and the Compiler's
+// superinstructions are ordered by it.
+using PairCounts = std::array<std::array<std::uint64_t, code::NUM_OPCODES>, code::NUM_OPCODES>;
+
+#ifdef PUNKY_VM_PROFILE
+inline constexpr bool PROFILES_OPCODES = true;
+#else
+inline constexpr bool PROFILES_OPCODES = false;
+#endif
+
+auto opcode_pairs() -> PairCounts&;
+
+// The stack, the globals and, through the callee slots on the stack, the
+// closures of live frames are the VM's roots.
+class VM : public gc::RootSet
+{
+public:
+    explicit VM(std::size_t max_depth = ops::DEFAULT_MAX_DEPTH);
+    ~VM() override;
+
+    // Globals persist across calls, so a REPL can run one Bytecode per line.
+    auto run(const compile::Bytecode& code) -> Object;
+
+    void trace(gc::Tracer& tracer) const override;
+
+private:
+    struct Frame
+    {
+        const std::uint8_t*       m_code;
+        const std::uint8_t*       m_ip;
+        const obj::FreeVariables* m_free;
+        std::size_t               m_base;
+    };
+
+    static constexpr std::size_t STACK_RESERVE  = 2048;
+    static constexpr std::size_t FRAMES_RESERVE = 256;
+
+    std::size_t m_max_depth;
+
+    std::vector<Object>                m_stack;
+    std::vector<Frame>                 m_frames;
+    std::vector<std::optional<Object>> m_globals;
+
+    const std::vector<Object>*      m_constants{};
+    const std::vector<sym::SymbolId>* m_global_names{};
+
+    auto execute() -> Object;
+    auto fail(Object error) -> Object;
+
+    auto pop() -> Object;
+};
+
+}  // namespace punky::vm
+
+#endif  // VM_HPP
@@ -1,11 +1,14 @@
 #ifndef AST_HPP
 #define AST_HPP
 
-#include <memory>
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include "Symbol.hpp"
 #include "Token.hpp"
 
 namespace punky::ast
@@ -101,15 +104,18 @@ public:
     [[nodiscard]] tok::TokenType type() const { return m_token.m_type; }
 
 protected:
-    [[nodiscard]] std::string tok_name() const { return m_token.m_literal.has_value()
-                                                          ? m_token.m_literal.value()
-                                                          : "novalue"; }
+    [[nodiscard]] std::string_view tok_name() const { return m_token.m_literal.has_value()
+                                                               ? m_token.m_literal.value()
+                                                               : "novalue"; }
+
+    [[nodiscard]] sym::SymbolId tok_symbol() const { return m_token.m_symbol; }
 
 private:
     Token m_token;
 };
 
-using ExprNodePtr    = std::unique_ptr<ast::ExprNode>;
+// Nodes are owned by the ast::Arena they were parsed into
+using ExprNodePtr    = ast::ExprNode*;
 using ExprNodeVector = std::vector<ExprNodePtr>;
 
 class StmtNode : public AstNode
@@ -137,7 +143,7 @@ private:
     Token m_token;
 };
 
-using StmtNodePtr    = std::unique_ptr<ast::StmtNode>;
+using StmtNodePtr    = ast::StmtNode*;
 using StmtNodeVector = std::vector<StmtNodePtr>;
 
 class Program : public AstNode
@@ -158,9 +164,10 @@ public:
         return AstType::Prog;
     }
 
-    void push_stmt(std::unique_ptr<ast::StmtNode> stmt);
+    void push_stmt(StmtNodePtr stmt);
 
-    StmtNodeVector& statements() { return m_statements; }
+    StmtNodeVector&                     statements() { return m_statements; }
+    [[nodiscard]] const StmtNodeVector& statements() const { return m_statements; }
 
 private:
     StmtNodeVector m_statements;
@@ -186,7 +193,37 @@ struct Identifier : public ExprNode
         return AstType::Identifier;
     }
 
-    [[nodiscard]] std::string name() const { return tok_name(); }
+    [[nodiscard]] std::string_view name() const { return tok_name(); }
+    [[nodiscard]] sym::SymbolId    symbol() const { return tok_symbol(); }
+
+    // Lexical address filled in by resolve::Resolver: the number of function
+    // scopes to step out of, and the slot within that scope's Environment.
+    [[nodiscard]] int depth() const { return m_depth; }
+    [[nodiscard]] int slot() const { return m_slot; }
+
+    // Whether the binding is a global, whose Environment an engine can reach
+    // without stepping out depth() times.
+    [[nodiscard]] bool is_global() const { return m_global; }
+
+    void bind(int depth, int slot, bool global) const
+    {
+        m_depth  = depth;
+        m_slot   = slot;
+        m_global = global;
+    }
+
+    // Where to look next while this binding's slot is still empty: the same
+    // name in an enclosing scope, as a lookup by name would find it. Null if
+    // the slot is always bound by the time it is read, or for a global.
+    [[nodiscard]] const Identifier* fallback() const { return m_fallback; }
+    void                            set_fallback(const Identifier* fallback) const { m_fallback = fallback; }
+
+private:
+    mutable int  m_depth{};
+    mutable int  m_slot{};
+    mutable bool m_global{};
+
+    mutable const Identifier* m_fallback{};
 };
 
 class LetStmt : public StmtNode
@@ -212,9 +249,10 @@ public:
         return AstType::LetStmt;
     }
 
-    [[nodiscard]] Identifier lhs() const { return m_name; }
+    [[nodiscard]] const Identifier& lhs() const { return m_name; }
 
-    [[nodiscard]] ExprNode* rhs() const { return m_value.get(); }
+    [[nodiscard]] ExprNode* rhs() const { return m_value; }
+    void                    set_rhs(ExprNodePtr value) { m_value = value; }
 
 private:
     Identifier  m_name;
@@ -243,7 +281,8 @@ public:
         return AstType::ReturnStmt;
     }
 
-    [[nodiscard]] ExprNode* ret_expr() const { return m_ret_expr.get(); }
+    [[nodiscard]] ExprNode* ret_expr() const { return m_ret_expr; }
+    void                    set_ret_expr(ExprNodePtr ret_expr) { m_ret_expr = ret_expr; }
 
 private:
     ExprNodePtr m_ret_expr;
@@ -271,7 +310,8 @@ public:
         return AstType::ExpressionStmt;
     }
 
-    [[nodiscard]] ExprNode* expression() const { return m_expression.get(); }
+    [[nodiscard]] ExprNode* expression() const { return m_expression; }
+    void                    set_expression(ExprNodePtr expression) { m_expression = expression; }
 
 private:
     ExprNodePtr m_expression;
@@ -291,7 +331,7 @@ public:
       StmtNode{std::move(tok)}
     {}
 
-    void push_stmt(std::unique_ptr<ast::StmtNode> stmt);
+    void push_stmt(StmtNodePtr stmt);
 
     [[nodiscard]] std::string to_string() const override;
 
@@ -316,7 +356,7 @@ public:
     IntLiteral& operator=(IntLiteral&& other) = default;
     ~IntLiteral() override                    = default;
 
-    IntLiteral(Token tok, int int_value) :
+    IntLiteral(Token tok, std::int64_t int_value) :
       ExprNode{std::move(tok)},
       m_int_value(int_value)
     {}
@@ -328,10 +368,10 @@ public:
         return AstType::Int;
     }
 
-    [[nodiscard]] int value() const { return m_int_value; }
+    [[nodiscard]] std::int64_t value() const { return m_int_value; }
 
 private:
-    int m_int_value;
+    std::int64_t m_int_value;
 };
 
 class PrefixExpression : public ExprNode
@@ -356,7 +396,8 @@ public:
         return AstType::Prefix;
     }
 
-    [[nodiscard]] ExprNode* right() const { return m_right.get(); }
+    [[nodiscard]] ExprNode* right() const { return m_right; }
+    void                    set_right(ExprNodePtr right) { m_right = right; }
 
 private:
     ExprNodePtr m_right;
@@ -385,8 +426,11 @@ public:
         return AstType::Infix;
     }
 
-    [[nodiscard]] ExprNode* left() const { return m_left.get(); }
-    [[nodiscard]] ExprNode* right() const { return m_right.get(); }
+    [[nodiscard]] ExprNode* left() const { return m_left; }
+    [[nodiscard]] ExprNode* right() const { return m_right; }
+
+    void set_left(ExprNodePtr left) { m_left = left; }
+    void set_right(ExprNodePtr right) { m_right = right; }
 
 private:
     ExprNodePtr m_left;
@@ -421,7 +465,7 @@ private:
     bool m_bool_value;
 };
 
-using OptIfAltBlk = std::optional<std::unique_ptr<ast::BlockStmt>>;
+using OptIfAltBlk = std::optional<ast::BlockStmt*>;
 
 class IfExpression : public ExprNode
 {
@@ -434,8 +478,8 @@ public:
     ~IfExpression() override                      = default;
 
     IfExpression(Token tok, ExprNodePtr condition,
-                 std::unique_ptr<ast::BlockStmt> consequence,
-                 OptIfAltBlk                     alternative) :
+                 ast::BlockStmt* consequence,
+                 OptIfAltBlk     alternative) :
       ExprNode{std::move(tok)},
       m_condition{std::move(condition)},
       m_consequence{std::move(consequence)},
@@ -449,21 +493,29 @@ public:
         return AstType::If;
     }
 
-    [[nodiscard]] ExprNode*  condition() const { return m_condition.get(); }
-    [[nodiscard]] BlockStmt* consequence() const { return m_consequence.get(); }
+    [[nodiscard]] ExprNode*  condition() const { return m_condition; }
+    [[nodiscard]] BlockStmt* consequence() const { return m_consequence; }
 
     [[nodiscard]] BlockStmt* alternative() const
     {
-        return m_alternative.has_value() ? m_alternative.value().get() : nullptr;
+        return m_alternative.has_value() ? m_alternative.value() : nullptr;
+    }
+
+    void set_condition(ExprNodePtr condition) { m_condition = condition; }
+
+    void set_branches(BlockStmt* consequence, OptIfAltBlk alternative)
+    {
+        m_consequence = consequence;
+        m_alternative = alternative;
     }
 
 private:
-    ExprNodePtr                     m_condition;
-    std::unique_ptr<ast::BlockStmt> m_consequence;
-    OptIfAltBlk                     m_alternative;
+    ExprNodePtr     m_condition;
+    ast::BlockStmt* m_consequence;
+    OptIfAltBlk     m_alternative;
 };
 
-using OptCallArgs = std::optional<std::unique_ptr<ExprNodeVector>>;
+using OptCallArgs = std::optional<ExprNodeVector*>;
 
 class CallExpression : public ExprNode
 {
@@ -489,16 +541,24 @@ public:
         return AstType::Call;
     }
 
-    [[nodiscard]] ExprNode* function() const { return m_function.get(); }
+    [[nodiscard]] ExprNode* function() const { return m_function; }
+    void                    set_function(ExprNodePtr function) { m_function = function; }
 
     [[nodiscard]] ExprNodeVector* arguments() const;
 
+    // Whether the call's value is the value of the enclosing function, so
+    // the call can take over its caller's frame. Set by resolve::Resolver.
+    [[nodiscard]] bool is_tail() const { return m_tail; }
+    void               set_tail(bool tail) const { m_tail = tail; }
+
 private:
     ExprNodePtr m_function;
     OptCallArgs m_arguments;
+
+    mutable bool m_tail{};
 };
 
-using OptFnParams = std::optional<std::unique_ptr<std::vector<ast::Identifier>>>;
+using OptFnParams = std::optional<std::vector<ast::Identifier>*>;
 
 class FunctionLiteral : public ExprNode
 {
@@ -511,7 +571,7 @@ public:
     ~FunctionLiteral() override                         = default;
 
     FunctionLiteral(Token tok, OptFnParams params,
-                    std::unique_ptr<BlockStmt> body) :
+                    BlockStmt* body) :
       ExprNode{std::move(tok)},
       m_params{std::move(params)},
       m_body{std::move(body)}
@@ -524,13 +584,31 @@ public:
         return AstType::Function;
     }
 
-    [[nodiscard]] StmtNode* body() const { return m_body.get(); }
+    // Called by opt::Folder before it rewrites the body, so inspect() keeps
+    // printing the function the way it was written.
+    void keep_source() { m_source = to_string(); }
+
+    [[nodiscard]] StmtNode* body() const { return m_body; }
 
     [[nodiscard]] std::vector<punky::ast::Identifier>* params() const;
 
+    // Slots needed by a call's Environment, counted by resolve::Resolver.
+    [[nodiscard]] int num_locals() const { return m_num_locals; }
+    void              set_num_locals(int num_locals) const { m_num_locals = num_locals; }
+
+    // Whether a call's Environment can outlive the call, which it does when
+    // the body creates a function that captures it. Until resolve::Resolver
+    // has looked at the body, it is assumed to.
+    [[nodiscard]] bool env_escapes() const { return m_env_escapes; }
+    void               set_env_escapes(bool escapes) const { m_env_escapes = escapes; }
+
 private:
-    OptFnParams                m_params;
-    std::unique_ptr<BlockStmt> m_body;
+    OptFnParams m_params;
+    BlockStmt*  m_body;
+    std::string m_source;
+
+    mutable int  m_num_locals{};
+    mutable bool m_env_escapes{true};
 };
 
 }  // namespace punky::ast
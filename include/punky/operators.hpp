@@ -0,0 +1,96 @@
+#ifndef OPERATORS_HPP
+#define OPERATORS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+
+#include "Object.hpp"
+#include "Token.hpp"
+
+namespace punky::ops
+{
+
+using punky::obj::Object;
+using punky::tok::TokenType;
+
+// Operator semantics shared by every execution engine, so that the
+// Evaluator, the VM and any AST pass agree on results and error messages.
+
+Object prefix(const TokenType& op, const Object& right);
+Object infix(const TokenType& op, const Object& left, const Object& right);
+
+// Int arithmetic as every engine does it: 64 bits, with an Error Object in
+// place of a result that overflows or divides by zero. These are inline so
+// an engine's fast path for ints stays one instruction and a branch that is
+// almost never taken.
+
+Object int_overflow_error(const TokenType& op, std::int64_t left, std::int64_t right);
+Object int_overflow_error(const TokenType& op, std::int64_t right);
+Object division_by_zero_error(std::int64_t left);
+
+inline Object int_add(std::int64_t left, std::int64_t right)
+{
+    std::int64_t result{};
+    if (__builtin_expect(__builtin_add_overflow(left, right, &result), false))
+        return int_overflow_error(TokenType::Plus, left, right);
+    return Object{result};
+}
+
+inline Object int_sub(std::int64_t left, std::int64_t right)
+{
+    std::int64_t result{};
+    if (__builtin_expect(__builtin_sub_overflow(left, right, &result), false))
+        return int_overflow_error(TokenType::Minus, left, right);
+    return Object{result};
+}
+
+inline Object int_mul(std::int64_t left, std::int64_t right)
+{
+    std::int64_t result{};
+    if (__builtin_expect(__builtin_mul_overflow(left, right, &result), false))
+        return int_overflow_error(TokenType::Asterisk, left, right);
+    return Object{result};
+}
+
+inline Object int_div(std::int64_t left, std::int64_t right)
+{
+    if (__builtin_expect(right == 0, false))
+        return division_by_zero_error(left);
+
+    // The one quotient that does not fit
+    if (__builtin_expect(right == -1 && left == std::numeric_limits<std::int64_t>::min(), false))
+        return int_overflow_error(TokenType::Slash, left, right);
+
+    return Object{left / right};
+}
+
+inline Object int_less(std::int64_t left, std::int64_t right) { return Object{left < right}; }
+inline Object int_greater(std::int64_t left, std::int64_t right) { return Object{left > right}; }
+inline Object int_equal(std::int64_t left, std::int64_t right) { return Object{left == right}; }
+inline Object int_not_equal(std::int64_t left, std::int64_t right) { return Object{left != right}; }
+
+bool is_truthy(const Object& obj);
+bool is_error(const Object& obj);
+
+// A returning value or an error stops evaluation until a function boundary.
+bool is_abrupt(const Object& obj);
+
+// What a call in tail position evaluates to: it unwinds to the function
+// boundary like a return would, and the engine makes the call from there.
+Object pending_tail_call();
+
+Object unknown_ident_error(std::string_view name);
+Object not_fn_error(const Object& not_fn);
+Object wrong_args_error(std::size_t want, std::size_t got);
+
+// How deeply calls may nest before they fail with stack_overflow_error()
+inline constexpr std::size_t DEFAULT_MAX_DEPTH = 1 << 16;
+
+Object stack_overflow_error(std::size_t max_depth);
+
+}  // namespace punky::ops
+
+#endif  // OPERATORS_HPP
@@ -1,14 +1,58 @@
 #ifndef UTILS_HPP
 #define UTILS_HPP
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
 namespace punky::utils
 {
 
-bool is_letter(char ch);
+enum CharClass : std::uint8_t
+{
+    Letter     = 1 << 0,
+    Digit      = 1 << 1,
+    Whitespace = 1 << 2,
+};
+
+// Classes of every byte as the "C" locale sees them ('_' counts as a letter),
+// so classifying a character is one load instead of a <cctype> call.
+inline constexpr std::array<std::uint8_t, 256> CHAR_CLASSES = [] {
+    std::array<std::uint8_t, 256> classes{};
+    for (int ch = 'a'; ch <= 'z'; ++ch)
+        classes[ch] |= Letter;
+    for (int ch = 'A'; ch <= 'Z'; ++ch)
+        classes[ch] |= Letter;
+    classes['_'] |= Letter;
+    for (int ch = '0'; ch <= '9'; ++ch)
+        classes[ch] |= Digit;
+    for (const int ch : {' ', '\t', '\n', '\v', '\f', '\r'})
+        classes[ch] |= Whitespace;
+    return classes;
+}();
+
+constexpr bool is_letter(char ch)
+{
+    return (CHAR_CLASSES[static_cast<unsigned char>(ch)] & Letter) != 0;
+}
+
+constexpr bool is_digit(char ch)
+{
+    return (CHAR_CLASSES[static_cast<unsigned char>(ch)] & Digit) != 0;
+}
 
-bool is_digit(char ch);
+constexpr bool is_whitespace(char ch)
+{
+    return (CHAR_CLASSES[static_cast<unsigned char>(ch)] & Whitespace) != 0;
+}
 
-bool is_whitespace(char ch);
+// Each returns the position of the first character at or after pos that is
+// not of the class, or src.size(). They classify 32 bytes per step with
+// AVX2, 16 with SSE2, and fall back to CHAR_CLASSES elsewhere.
+std::size_t skip_letters(std::string_view src, std::size_t pos);
+std::size_t skip_digits(std::string_view src, std::size_t pos);
+std::size_t skip_whitespace(std::string_view src, std::size_t pos);
 
 }  // namespace punky::utils
 
@@ -0,0 +1,51 @@
+#include "punky/Arena.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+namespace punky::ast
+{
+
+Arena::~Arena()
+{
+    // In reverse order of construction, like automatic objects
+    for (auto it = m_dtors.rbegin(); it != m_dtors.rend(); ++it)
+        it->m_destroy(it->m_obj);
+}
+
+auto Arena::copy_source(std::string_view source) -> std::string_view
+{
+    auto* text = static_cast<char*>(allocate(source.size() + 1, 1));
+    std::memcpy(text, source.data(), source.size());
+    text[source.size()] = '\0';
+    return std::string_view{text, source.size()};
+}
+
+auto Arena::allocate(std::size_t size, std::size_t align) -> void*
+{
+    auto addr    = reinterpret_cast<std::uintptr_t>(m_cursor);
+    auto aligned = (addr + align - 1) & ~(align - 1);
+
+    if (!m_cursor || aligned + size > reinterpret_cast<std::uintptr_t>(m_end))
+    {
+        // Oversized requests get a block of their own
+        const auto block_size = std::max(BLOCK_SIZE, size + align);
+        m_blocks.emplace_back(new std::byte[block_size]);
+
+        m_cursor = m_blocks.back().get();
+        m_end    = m_cursor + block_size;
+
+        addr    = reinterpret_cast<std::uintptr_t>(m_cursor);
+        aligned = (addr + align - 1) & ~(align - 1);
+    }
+
+    m_cursor = reinterpret_cast<std::byte*>(aligned + size);
+    m_bytes += size;
+    return reinterpret_cast<void*>(aligned);
+}
+
+}  // namespace punky::ast
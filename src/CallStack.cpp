@@ -0,0 +1,103 @@
+#include "punky/CallStack.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#ifdef PUNKY_STACK_SEGMENTS
+#    include <sys/mman.h>
+#    include <ucontext.h>
+#endif
+
+#include <punky/Environment.hpp>
+#include <punky/Heap.hpp>
+
+namespace punky::eval
+{
+
+#ifdef PUNKY_STACK_SEGMENTS
+
+struct SegmentEntry
+{
+    void (*m_entry)(void*);
+    void* m_arg;
+};
+
+// makecontext() can only pass ints to the function it starts, so the
+// address of the SegmentEntry is handed over in two halves.
+static void start_segment(unsigned int high, unsigned int low)
+{
+    const auto  address = (static_cast<std::uint64_t>(high) << 32) | low;
+    const auto* entry   = reinterpret_cast<const SegmentEntry*>(static_cast<std::uintptr_t>(address));
+    entry->m_entry(entry->m_arg);
+}
+
+#endif
+
+CallStack::CallStack(std::size_t max_depth) :
+  m_max_depth{max_depth}
+{
+    gc::heap().add_roots(*this);
+}
+
+CallStack::~CallStack()
+{
+    gc::heap().remove_roots(*this);
+
+#ifdef PUNKY_STACK_SEGMENTS
+    for (auto* segment : m_segments)
+        ::munmap(segment, SEGMENT_SIZE);
+#endif
+}
+
+void CallStack::trace(gc::Tracer& tracer) const
+{
+    for (const auto* env : m_frames)
+        tracer.mark(env);
+}
+
+void CallStack::set_native_limit(std::size_t budget)
+{
+    const char here{};
+    m_native_limit = reinterpret_cast<std::uintptr_t>(&here) - budget;
+}
+
+#ifdef PUNKY_STACK_SEGMENTS
+
+void CallStack::run_on_segment(void (*entry)(void*), void* arg)
+{
+    if (m_segments_used == m_segments.size())
+    {
+        // Pages are only backed once the calls running on them touch them
+        auto* segment = ::mmap(nullptr, SEGMENT_SIZE, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+        if (segment == MAP_FAILED)
+            throw std::bad_alloc{};
+        m_segments.push_back(segment);
+    }
+    auto* segment = m_segments[m_segments_used++];
+
+    const auto segment_entry = SegmentEntry{entry, arg};
+    const auto address       = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(&segment_entry));
+
+    ucontext_t caller{};
+    ucontext_t callee{};
+    ::getcontext(&callee);
+    callee.uc_stack.ss_sp   = segment;
+    callee.uc_stack.ss_size = SEGMENT_SIZE;
+    callee.uc_link          = &caller;
+    ::makecontext(&callee, reinterpret_cast<void (*)()>(start_segment), 2,
+                  static_cast<unsigned int>(address >> 32), static_cast<unsigned int>(address));
+
+    const auto caller_limit = m_native_limit;
+    m_native_limit          = reinterpret_cast<std::uintptr_t>(segment) + SEGMENT_RESERVE;
+
+    ::swapcontext(&caller, &callee);
+
+    m_native_limit = caller_limit;
+    --m_segments_used;
+}
+
+#endif
+
+}  // namespace punky::eval
@@ -0,0 +1,97 @@
+#include "punky/Code.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <string_view>
+
+namespace punky::code
+{
+
+static constexpr auto num_operands(OpCode op) -> std::size_t
+{
+    switch (op)
+    {
+        case OpCode::Constant:
+        case OpCode::Jump:
+        case OpCode::JumpNotTruthy:
+        case OpCode::JumpIfBound:
+        case OpCode::JumpIfNotLess:
+        case OpCode::JumpIfNotGreater:
+        case OpCode::JumpIfNotEqual:
+        case OpCode::GetGlobal:
+        case OpCode::SetGlobal:
+        case OpCode::GetLocal:
+        case OpCode::SetLocal:
+        case OpCode::MakeCell:
+        case OpCode::GetCell:
+        case OpCode::SetCell:
+        case OpCode::GetFree:
+        case OpCode::GetFreeCell:
+        case OpCode::Call:
+        case OpCode::TailCall:
+            return 1;
+
+        case OpCode::Closure:
+        case OpCode::AddLocalConst:
+        case OpCode::SubLocalConst:
+            return 2;
+
+        default:
+            return 0;
+    }
+}
+
+auto to_string(OpCode op) -> std::string_view
+{
+    // In OpCode order
+    static constexpr std::string_view NAMES[] = {
+      "Constant", "Pop",
+      "Null", "True", "False", "Empty",
+      "Add", "Sub", "Mul", "Div",
+      "Equal", "NotEqual", "Greater", "Less",
+      "Minus", "Bang",
+      "Jump", "JumpNotTruthy", "JumpIfBound",
+      "GetGlobal", "SetGlobal", "GetLocal", "SetLocal",
+      "MakeCell", "GetCell", "SetCell", "GetFree", "GetFreeCell",
+      "Closure",
+      "Call", "TailCall", "ReturnValue",
+      "AddLocalConst", "SubLocalConst",
+      "JumpIfNotLess", "JumpIfNotGreater", "JumpIfNotEqual",
+    };
+    static_assert(std::size(NAMES) == NUM_OPCODES);
+
+    return NAMES[static_cast<std::size_t>(op)];
+}
+
+static void put_operand(std::uint8_t* dest, int operand)
+{
+    const auto val = static_cast<std::uint32_t>(operand);
+    for (std::size_t i = 0; i < OPERAND_WIDTH; ++i)
+        dest[i] = static_cast<std::uint8_t>(val >> (8 * i));
+}
+
+auto emit(Instructions& ins, OpCode op, std::initializer_list<int> operands) -> std::size_t
+{
+    const auto pos = ins.size();
+
+    ins.resize(pos + 1 + num_operands(op) * OPERAND_WIDTH);
+    ins[pos] = static_cast<std::uint8_t>(op);
+
+    auto* dest = ins.data() + pos + 1;
+    for (const auto operand : operands)
+    {
+        put_operand(dest, operand);
+        dest += OPERAND_WIDTH;
+    }
+
+    return pos;
+}
+
+void patch_operand(Instructions& ins, std::size_t pos, int operand)
+{
+    put_operand(ins.data() + pos + 1, operand);
+}
+
+}  // namespace punky::code
@@ -0,0 +1,400 @@
+#include "punky/Compiler.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <punky/CObject.hpp>
+#include <punky/Code.hpp>
+#include <punky/FlatAst.hpp>
+#include <punky/Folder.hpp>
+#include <punky/Object.hpp>
+#include <punky/Symbol.hpp>
+#include <punky/Token.hpp>
+#include <punky/ast.hpp>
+#include <punky/operators.hpp>
+
+namespace punky::compile
+{
+
+using punky::ast::AstType;
+using punky::code::OpCode;
+using punky::obj::Object;
+using punky::obj::ObjectType;
+using punky::tok::TokenType;
+
+static constexpr auto infix_opcode(TokenType type) -> OpCode;
+
+// Superinstructions for the sequences that make up most of the instructions
+// run by arithmetic-heavy scripts: a local combined with an int literal, as
+// in n - 1, and a comparison that only decides an if. Each table is in the
+// order of how often the macro/ benchmarks run the opcode pair the fusion
+// removes, as counted by punky_bench --opcode-pairs.
+struct Fusion
+{
+    TokenType m_op;
+    OpCode    m_fused;
+};
+
+static constexpr std::array LOCAL_CONST_FUSIONS{
+  Fusion{TokenType::Minus, OpCode::SubLocalConst},
+  Fusion{TokenType::Plus, OpCode::AddLocalConst},
+};
+
+static constexpr std::array COMPARE_JUMP_FUSIONS{
+  Fusion{TokenType::Less, OpCode::JumpIfNotLess},
+  Fusion{TokenType::EqualEqual, OpCode::JumpIfNotEqual},
+  Fusion{TokenType::Greater, OpCode::JumpIfNotGreater},
+};
+
+template <std::size_t N>
+static constexpr auto find_fusion(const std::array<Fusion, N>& fusions, TokenType op)
+  -> std::optional<OpCode>
+{
+    for (const auto& fusion : fusions)
+    {
+        if (fusion.m_op == op)
+            return fusion.m_fused;
+    }
+    return std::nullopt;
+}
+
+auto Compiler::compile(ast::FlatAst ast) -> Bytecode
+{
+    m_main.clear();
+    m_scopes.clear();
+
+    m_ast   = &m_asts.emplace_back(std::move(ast));
+    m_folds = opt::fold(*m_ast);
+    m_resolver.resolve(*m_ast);
+
+    compile_block(m_ast->root());
+    emit(OpCode::ReturnValue);
+
+    m_ast = nullptr;
+    m_folds.m_values.clear();
+    m_folds.m_declares.clear();
+    return Bytecode{std::move(m_main), &m_constants, &m_resolver.global_names()};
+}
+
+auto Compiler::instructions() -> code::Instructions&
+{
+    return m_scopes.empty() ? m_main : m_scopes.back().m_instructions;
+}
+
+auto Compiler::emit(OpCode op, std::initializer_list<int> operands) -> std::size_t
+{
+    return code::emit(instructions(), op, operands);
+}
+
+auto Compiler::add_constant(Object obj) -> int
+{
+    m_constants.push_back(std::move(obj));
+    return static_cast<int>(m_constants.size() - 1);
+}
+
+// Leaves exactly one value on the stack: the value of the last statement,
+// EmptyOut for a trailing let, or null for an empty block.
+void Compiler::compile_block(ast::NodeId block)
+{
+    const auto stmts = m_ast->statements(block);
+    if (stmts.empty())
+    {
+        emit(OpCode::Null);
+        return;
+    }
+
+    for (std::uint32_t i = 0; i + 1 < stmts.size(); ++i)
+        compile_statement(stmts[i]);
+
+    const auto last = stmts.back();
+    switch (m_ast->kind(last))
+    {
+        case AstType::ExpressionStmt:
+            compile_expression(m_ast->expression(last));
+            break;
+
+        case AstType::LetStmt:
+            compile_let(last);
+            emit(OpCode::Empty);
+            break;
+
+        default:
+            compile_statement(last);
+            break;
+    }
+}
+
+void Compiler::compile_statement(ast::NodeId stmt)
+{
+    switch (m_ast->kind(stmt))
+    {
+        case AstType::ExpressionStmt:
+            compile_expression(m_ast->expression(stmt));
+            emit(OpCode::Pop);
+            break;
+
+        case AstType::LetStmt:
+            compile_let(stmt);
+            break;
+
+        case AstType::ReturnStmt:
+            compile_expression(m_ast->expression(stmt));
+            emit(OpCode::ReturnValue);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void Compiler::compile_let(ast::NodeId let)
+{
+    compile_expression(m_ast->let_value(let));
+
+    const auto& target = m_resolver.target(let);
+    if (target.m_storage == resolve::Storage::Global)
+        emit(OpCode::SetGlobal, {static_cast<int>(target.m_index)});
+    else
+        emit(is_cell(target) ? OpCode::SetCell : OpCode::SetLocal, {static_cast<int>(target.m_index)});
+}
+
+void Compiler::compile_expression(ast::NodeId expr)
+{
+    // Literals, and whatever folds to one
+    if (const auto& value = m_folds.m_values[expr]; value.has_value())
+    {
+        if (value->type() == ObjectType::Int)
+            emit(OpCode::Constant, {add_constant(value.value())});
+        else
+            emit(value->as_bool() ? OpCode::True : OpCode::False);
+        return;
+    }
+
+    switch (m_ast->kind(expr))
+    {
+        case AstType::Prefix:
+            compile_expression(m_ast->right(expr));
+            emit(m_ast->op(expr) == TokenType::Minus ? OpCode::Minus : OpCode::Bang);
+            break;
+
+        case AstType::Infix:
+            if (compile_local_const(expr))
+                break;
+
+            compile_expression(m_ast->left(expr));
+            compile_expression(m_ast->right(expr));
+            emit(infix_opcode(m_ast->op(expr)));
+            break;
+
+        case AstType::If:
+            compile_if(expr);
+            break;
+
+        case AstType::Identifier:
+            compile_identifier(expr);
+            break;
+
+        case AstType::Function:
+            compile_function(expr);
+            break;
+
+        case AstType::Call:
+            compile_call(expr);
+            break;
+
+        default:
+            emit(OpCode::Null);
+            break;
+    }
+}
+
+void Compiler::compile_if(ast::NodeId if_expr)
+{
+    // A constant condition leaves one branch, unless the other binds a name
+    if (const auto live = opt::live_branch(*m_ast, m_folds, if_expr); live)
+    {
+        if (*live != ast::NO_NODE)
+            compile_block(*live);
+        else
+            emit(OpCode::Null);
+        return;
+    }
+
+    const auto jump_not_truthy = compile_condition(m_ast->condition(if_expr));
+
+    compile_block(m_ast->consequence(if_expr));
+    const auto jump = emit(OpCode::Jump, {0});
+
+    code::patch_operand(instructions(), jump_not_truthy, static_cast<int>(instructions().size()));
+
+    if (const auto alt = m_ast->alternative(if_expr); alt != ast::NO_NODE)
+        compile_block(alt);
+    else
+        emit(OpCode::Null);
+
+    code::patch_operand(instructions(), jump, static_cast<int>(instructions().size()));
+}
+
+// Emits the jump taken when cond is not truthy, returning its offset
+auto Compiler::compile_condition(ast::NodeId cond) -> std::size_t
+{
+    if (m_superinstructions && m_ast->kind(cond) == AstType::Infix)
+    {
+        if (const auto fused = find_fusion(COMPARE_JUMP_FUSIONS, m_ast->op(cond)); fused)
+        {
+            if (!compile_local_const(m_ast->left(cond)))
+                compile_expression(m_ast->left(cond));
+            compile_expression(m_ast->right(cond));
+            return emit(fused.value(), {0});
+        }
+    }
+
+    compile_expression(cond);
+    return emit(OpCode::JumpNotTruthy, {0});
+}
+
+// Emits infix as one superinstruction if it is a local combined with an int
+// literal, returning whether it did
+auto Compiler::compile_local_const(ast::NodeId infix) -> bool
+{
+    if (!m_superinstructions || m_ast->kind(infix) != AstType::Infix)
+        return false;
+
+    const auto  left  = m_ast->left(infix);
+    const auto& right = m_folds.m_values[m_ast->right(infix)];
+    if (m_ast->kind(left) != AstType::Identifier || !right.has_value()
+        || right->type() != ObjectType::Int)
+        return false;
+
+    const auto fused = find_fusion(LOCAL_CONST_FUSIONS, m_ast->op(infix));
+    if (!fused.has_value())
+        return false;
+
+    const auto reads = m_resolver.reads(left);
+    if (reads.size() != 1 || reads[0].m_storage != resolve::Storage::Local || is_cell(reads[0]))
+        return false;
+
+    emit(fused.value(), {static_cast<int>(reads[0].m_index), add_constant(right.value())});
+    return true;
+}
+
+void Compiler::compile_call(ast::NodeId call)
+{
+    compile_expression(m_ast->function(call));
+
+    const auto args = m_ast->arguments(call);
+    for (const auto arg : args)
+        compile_expression(arg);
+
+    emit(m_resolver.tail(call) ? OpCode::TailCall : OpCode::Call, {static_cast<int>(args.size())});
+}
+
+void Compiler::compile_function(ast::NodeId fn)
+{
+    const auto& layout = m_resolver.function(fn);
+    m_scopes.push_back(Scope{{}, &layout});
+
+    for (std::uint32_t slot = 0; slot < layout.m_num_locals; ++slot)
+    {
+        if (layout.m_cells[slot])
+            emit(OpCode::MakeCell, {static_cast<int>(slot)});
+    }
+
+    compile_block(m_ast->body(fn));
+    emit(OpCode::ReturnValue);
+
+    auto scope = std::move(m_scopes.back());
+    m_scopes.pop_back();
+
+    // The Cells of free variables are pushed in the enclosing scope, so
+    // the closure shares them with it.
+    for (const auto& capture : layout.m_captures)
+    {
+        emit(capture.m_storage == resolve::Storage::Local ? OpCode::GetLocal : OpCode::GetFreeCell,
+             {static_cast<int>(capture.m_index)});
+    }
+
+    const auto& compiled = m_functions.emplace_back(std::make_unique<obj::CompiledFunction>(
+      obj::CompiledFunction{std::move(scope.m_instructions),
+                            layout.m_num_locals,
+                            static_cast<std::uint32_t>(m_ast->params(fn).size()),
+                            m_ast,
+                            fn}));
+
+    const auto index = add_constant(obj::make_closure(compiled.get(), {}));
+    emit(OpCode::Closure, {index, static_cast<int>(layout.m_captures.size())});
+}
+
+// Reads each place the name may be in until one is bound. The last one
+// fails at run time if it is a global that never was bound, as in the
+// Evaluator.
+void Compiler::compile_identifier(ast::NodeId ident)
+{
+    const auto reads = m_resolver.reads(ident);
+
+    std::vector<std::size_t> jumps;
+    for (std::uint32_t i = 0; i < reads.size(); ++i)
+    {
+        const auto& read  = reads[i];
+        const auto  index = static_cast<int>(read.m_index);
+        switch (read.m_storage)
+        {
+            case resolve::Storage::Global:
+                emit(OpCode::GetGlobal, {index});
+                break;
+
+            case resolve::Storage::Local:
+                emit(is_cell(read) ? OpCode::GetCell : OpCode::GetLocal, {index});
+                break;
+
+            case resolve::Storage::Free:
+                emit(OpCode::GetFree, {index});
+                break;
+        }
+
+        if (i + 1 < reads.size())
+            jumps.push_back(emit(OpCode::JumpIfBound, {0}));
+    }
+
+    for (const auto jump : jumps)
+        code::patch_operand(instructions(), jump, static_cast<int>(instructions().size()));
+}
+
+bool Compiler::is_cell(const resolve::Binding& binding) const
+{
+    return binding.m_storage == resolve::Storage::Local && !m_scopes.empty()
+           && m_scopes.back().m_fn->m_cells[binding.m_index];
+}
+
+static constexpr auto infix_opcode(TokenType type) -> OpCode
+{
+    switch (type)
+    {
+        case TokenType::Plus:
+            return OpCode::Add;
+        case TokenType::Minus:
+            return OpCode::Sub;
+        case TokenType::Asterisk:
+            return OpCode::Mul;
+        case TokenType::Slash:
+            return OpCode::Div;
+        case TokenType::EqualEqual:
+            return OpCode::Equal;
+        case TokenType::BangEqual:
+            return OpCode::NotEqual;
+        case TokenType::Greater:
+            return OpCode::Greater;
+        case TokenType::Less:
+        default:
+            return OpCode::Less;
+    }
+}
+
+}  // namespace punky::compile
@@ -1,30 +1,77 @@
 #include "punky/Environment.hpp"
 
+#include <cstddef>
 #include <optional>
-#include <string>
-#include <utility>
+
+#include <punky/Heap.hpp>
+#include <punky/Object.hpp>
 
 namespace punky::env
 {
 
-obj::Object Environment::set(std::string name, const obj::Object& value)
+auto Environment::make(Environment* outer, std::size_t num_slots) -> Environment*
+{
+    return gc::heap().make<Environment>(outer, num_slots);
+}
+
+auto Environment::make_young(Environment* outer, std::size_t num_slots) -> Environment*
+{
+    auto* env = gc::heap().make_young<Environment>(num_slots * sizeof(Slot), outer, num_slots, true);
+    return env ? env : make(outer, num_slots);
+}
+
+void Environment::release(Environment* env)
 {
-    m_store[std::move(name)] = value;
+    if (env->is_young())
+        gc::heap().release_young(env);
+}
+
+obj::Object Environment::set(std::size_t slot, const obj::Object& value)
+{
+    if (slot >= m_num_slots)
+        grow(slot + 1);
+
+    m_slots[slot] = value;
+    m_version     = next_version();
     return value;
 }
 
-auto Environment::get(const std::string& name) const -> std::optional<obj::Object>
+std::uint64_t Environment::next_version()
 {
-    if (const auto res = m_store.find(name); res != m_store.cend())
-        return res->second;
+    static std::uint64_t s_version{};
+    return ++s_version;
+}
 
-    if (m_outer)
-    {
-        if (const auto outer_res = m_outer->get(name); outer_res.has_value())
-            return outer_res.value();
-    }
+void Environment::grow(std::size_t num_slots)
+{
+    if (m_slots != m_storage.data())
+        m_storage.assign(m_slots, m_slots + m_num_slots);
+
+    m_storage.resize(num_slots);
+    m_slots     = m_storage.data();
+    m_num_slots = num_slots;
+}
+
+auto Environment::get(std::size_t depth, std::size_t slot) const -> std::optional<obj::Object>
+{
+    const auto* env = this;
+    for (; depth > 0; --depth)
+        env = env->m_outer;
+
+    if (slot < env->m_num_slots)
+        return env->m_slots[slot];
 
     return std::nullopt;
 }
 
+void Environment::trace(gc::Tracer& tracer) const
+{
+    for (std::size_t i = 0; i < m_num_slots; ++i)
+    {
+        if (m_slots[i].has_value())
+            tracer.mark(m_slots[i].value());
+    }
+    tracer.mark(m_outer);
+}
+
 }  // namespace punky::env
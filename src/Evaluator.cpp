@@ -1,61 +1,60 @@
 #include "punky/Evaluator.hpp"
 
-#include <memory>
+#include <cstddef>
+#include <optional>
 #include <utility>
 #include <vector>
 
+#include <punky/CallStack.hpp>
 #include <punky/Environment.hpp>
+#include <punky/FObject.hpp>
+#include <punky/Heap.hpp>
 #include <punky/Object.hpp>
 #include <punky/Token.hpp>
 #include <punky/ast.hpp>
+#include <punky/operators.hpp>
 
 namespace punky::eval
 {
 
 using punky::ast::AstType;
+using punky::obj::extend_fn_env;
 using punky::obj::FunctionObject;
 using punky::obj::Object;
 using punky::obj::ObjectType;
+using punky::ops::is_abrupt;
+using punky::ops::is_error;
+using punky::ops::is_truthy;
 using punky::tok::TokenType;
 
-const Object Evaluator::M_TRUE_OBJ  = Object{ObjectType::Boolean, true};
-const Object Evaluator::M_FALSE_OBJ = Object{ObjectType::Boolean, false};
-const Object Evaluator::M_NULL_OBJ  = Object{ObjectType::Null, std::monostate{}};
+const Object Evaluator::M_NULL_OBJ = Object{ObjectType::Null};
 
-static bool is_truthy(const Object& obj);
-static bool is_error(const Object& obj);
-
-static Object unknown_op_error(const Object& right);
-static Object unknown_op_error(const TokenType& op, const Object& right);
-static Object unknown_op_error(const TokenType& op, const Object& left, const Object& right);
-static Object type_mismatch_error(const TokenType& op, const Object& left, const Object& right);
-static Object unknown_ident_error(const ast::Identifier& ident);
-static Object not_fn_error(const Object& not_fn);
-
-static std::unique_ptr<env::Environment> extend_fn_env(const FunctionObject&      fn_obj,
-                                                       const std::vector<Object>& args);
-
-Evaluator::Evaluator(std::unique_ptr<ast::Program> prog) :
-  m_program{std::move(prog)}
+Evaluator::Evaluator(const ast::Program& prog, std::size_t max_depth) :
+  m_program{&prog},
+  m_calls{max_depth}
 {
 }
 
-Object Evaluator::interpret(env::Environment& env) const
+Object Evaluator::interpret(env::Environment& env)
 {
+    m_globals = &env;
     return eval_program(env);
 }
 
-Object Evaluator::eval_program(env::Environment& env) const
+Object Evaluator::eval_program(env::Environment& env)
 {
     Object result{};
     for (const auto& stmt : m_program->statements())
     {
         result = eval(*stmt, env);
 
-        if (result.m_type == ObjectType::Return)
-            return std::any_cast<Object>(std::get<std::any>(result.m_value));
+        if (result.returning())
+        {
+            result.set_returning(false);
+            return result;
+        }
 
-        if (result.m_type == ObjectType::Error)
+        if (is_error(result))
             return result;
     }
     return result;
@@ -74,44 +73,47 @@ Object Evaluator::eval(const ast::AstNode& node, env::Environment& env)
         case AstType::ReturnStmt:
         {
             auto val = eval(*node.return_stmt()->ret_expr(), env);
-            return is_error(val) ? val
-                                 : Object{ObjectType::Return, val};
+            if (!is_error(val))
+                val.set_returning(true);
+            return val;
         }
 
         case AstType::LetStmt:
         {
             auto val = eval(*node.let_stmt()->rhs(), env);
-            if (is_error(val))
+            if (is_abrupt(val))
                 return val;
 
-            env.set(node.let_stmt()->lhs().name(), val);
-            return Object{ObjectType::EmptyOut, std::monostate{}};
+            env.set(node.let_stmt()->lhs().slot(), val);
+            return Object{ObjectType::EmptyOut};
         }
 
         case AstType::Int:
-            return Object{ObjectType::Int, node.int_lit()->value()};
+            return Object{node.int_lit()->value()};
 
         case AstType::Bool:
-            return Object{ObjectType::Boolean, node.boolean()->value()};
+            return Object{node.boolean()->value()};
 
         case AstType::Prefix:
         {
             auto right = eval(*node.prefix_expr()->right(), env);
-            return is_error(right) ? right
-                                   : eval_prefix_expr(node.expr()->type(), right);
+            return is_abrupt(right) ? right
+                                   : ops::prefix(node.expr()->type(), right);
         }
 
         case AstType::Infix:
         {
             auto left = eval(*node.infix_expr()->left(), env);
-            if (is_error(left))
+            if (is_abrupt(left))
                 return left;
 
+            const auto left_root = gc::Root{left};
+
             auto right = eval(*node.infix_expr()->right(), env);
-            if (is_error(right))
+            if (is_abrupt(right))
                 return right;
 
-            return eval_infix_expr(node.expr()->type(), left, right);
+            return ops::infix(node.expr()->type(), left, right);
         }
 
         case AstType::If:
@@ -122,20 +124,30 @@ Object Evaluator::eval(const ast::AstNode& node, env::Environment& env)
 
         case AstType::Function:
         {
-            // Fix this : This node.fn_lit() returned pointer is deleted at each repl.
-            return Object{ObjectType::Function, FunctionObject{node.fn_lit(), &env}};
+            return obj::make_function(node.fn_lit(), &env);
         }
         case AstType::Call:
         {
             auto fn = eval(*node.call_expr()->function(), env);
-            if (is_error(fn))
+            if (is_abrupt(fn))
                 return fn;
 
-            auto args = eval_expressions(node.call_expr()->arguments(), env);
-            if (args.size() == 1 && is_error(args.front()))
-                return args.front();
-
-            return apply_function(fn, args);
+            const auto base = m_args.size();
+            m_args.push_back(fn);
+            if (auto abrupt = eval_arguments(node.call_expr()->arguments(), env); abrupt.has_value())
+            {
+                m_args.resize(base);
+                return abrupt.value();
+            }
+
+            if (node.call_expr()->is_tail() && fn.type() == ObjectType::Function)
+            {
+                m_tail_call.assign(m_args.begin() + static_cast<std::ptrdiff_t>(base), m_args.end());
+                m_args.resize(base);
+                return ops::pending_tail_call();
+            }
+
+            return apply_function(base);
         }
 
         default:
@@ -150,123 +162,17 @@ Object Evaluator::eval_block_statements(const ast::BlockStmt& block, env::Enviro
     {
         result = eval(*stmt, env);
 
-        if (result.m_type == ObjectType::Return || result.m_type == ObjectType::Error)
+        if (is_abrupt(result))
             return result;
     }
     return result;
 }
 
-Object Evaluator::eval_prefix_expr(const TokenType& op, const Object& right)
-{
-    switch (op)
-    {
-        case TokenType::Bang:
-            return eval_bang_prefix_expr(right);
-
-        case TokenType::Minus:
-            return eval_minus_prefix_expr(right);
-
-        default:
-            return unknown_op_error(op, right);
-    }
-}
-
-Object Evaluator::eval_bang_prefix_expr(const Object& right)
-{
-    switch (right.m_type)
-    {
-        case ObjectType::Boolean:
-            return Object{ObjectType::Boolean, !std::get<bool>(right.m_value)};
-
-        case ObjectType::Null:
-            return M_TRUE_OBJ;
-
-        default:
-            return M_FALSE_OBJ;
-    }
-}
-
-Object Evaluator::eval_minus_prefix_expr(const Object& right)
-{
-    if (right.m_type == ObjectType::Int)
-        return Object{ObjectType::Int, -std::get<int>(right.m_value)};
-
-    return unknown_op_error(right);
-}
-
-Object Evaluator::eval_infix_expr(const TokenType& op, const Object& left, const Object& right)
-{
-    if (left.m_type == ObjectType::Int && right.m_type == ObjectType::Int)
-        return eval_int_infix_expr(op, left, right);
-
-    if (left.m_type == ObjectType::Boolean && right.m_type == ObjectType::Boolean)
-        return eval_bool_infix_expr(op, left, right);
-
-    if (left.m_type != right.m_type)
-        return type_mismatch_error(op, left, right);
-
-    return unknown_op_error(op, left, right);
-}
-
-Object Evaluator::eval_int_infix_expr(const TokenType& op, const Object& left, const Object& right)
-{
-    const auto left_val  = std::get<int>(left.m_value);
-    const auto right_val = std::get<int>(right.m_value);
-
-    switch (op)
-    {
-        case TokenType::Plus:
-            return Object{ObjectType::Int, left_val + right_val};
-
-        case TokenType::Minus:
-            return Object{ObjectType::Int, left_val - right_val};
-
-        case TokenType::Asterisk:
-            return Object{ObjectType::Int, left_val * right_val};
-
-        case TokenType::Slash:
-            return Object{ObjectType::Int, left_val / right_val};
-
-        case TokenType::Less:
-            return Object{ObjectType::Boolean, left_val < right_val};
-
-        case TokenType::Greater:
-            return Object{ObjectType::Boolean, left_val > right_val};
-
-        case TokenType::EqualEqual:
-            return Object{ObjectType::Boolean, left_val == right_val};
-
-        case TokenType::BangEqual:
-            return Object{ObjectType::Boolean, left_val != right_val};
-
-        default:
-            return unknown_op_error(op, left, right);
-    }
-}
-
-Object Evaluator::eval_bool_infix_expr(const TokenType& op, const Object& left, const Object& right)
-{
-    const auto left_val  = std::get<bool>(left.m_value);
-    const auto right_val = std::get<bool>(right.m_value);
-
-    switch (op)
-    {
-        case TokenType::EqualEqual:
-            return Object{ObjectType::Boolean, left_val == right_val};
-
-        case TokenType::BangEqual:
-            return Object{ObjectType::Boolean, left_val != right_val};
-
-        default:
-            return unknown_op_error(op, left, right);
-    }
-}
-
 Object Evaluator::eval_if_expr(const ast::IfExpression& if_expr, env::Environment& env)
 {
     auto condition = eval(*if_expr.condition(), env);
 
-    if (is_error(condition))
+    if (is_abrupt(condition))
         return condition;
 
     if (is_truthy(condition))
@@ -278,117 +184,95 @@ Object Evaluator::eval_if_expr(const ast::IfExpression& if_expr, env::Environmen
     return M_NULL_OBJ;
 }
 
-Object Evaluator::eval_identifier(const ast::Identifier& ident, const env::Environment& env)
+Object Evaluator::eval_identifier(const ast::Identifier& ident, const env::Environment& env) const
 {
-    if (auto val = env.get(ident.name()); val.has_value())
-        return val.value();
-    return unknown_ident_error(ident);
+    for (const auto* binding = &ident; binding; binding = binding->fallback())
+    {
+        // A global needs no walk out to the outermost Environment
+        const auto val = binding->is_global() ? m_globals->get(0, binding->slot())
+                                              : env.get(binding->depth(), binding->slot());
+        if (val.has_value())
+            return val.value();
+    }
+    return ops::unknown_ident_error(ident.name());
 }
 
-ObjectVector Evaluator::eval_expressions(const ast::ExprNodeVector* exprs, env::Environment& env)
+// Pushes the value of each of exprs onto m_args, stopping at the first that
+// is abrupt, which is returned instead.
+std::optional<Object> Evaluator::eval_arguments(const ast::ExprNodeVector* exprs, env::Environment& env)
 {
     if (exprs)
     {
-        std::vector<Object> result;
         for (const auto& expr : *exprs)
         {
             auto evaluated = eval(*expr, env);
-            if (is_error(evaluated))
-                return std::vector<Object>{evaluated};
+            if (is_abrupt(evaluated))
+                return evaluated;
 
-            result.push_back(evaluated);
+            m_args.push_back(evaluated);
         }
-        return result;
     }
-    return {};
+    return std::nullopt;
 }
 
-Object Evaluator::apply_function(const Object& fn, const ObjectVector& args)
+Object Evaluator::apply_function(std::size_t base)
 {
-    if (fn.m_type == ObjectType::Function)
+    if (m_args[base].type() != ObjectType::Function)
     {
-        auto fn_obj = std::get<FunctionObject>(fn.m_value);
-        auto fn_env = extend_fn_env(fn_obj, args);
-        auto value  = eval(*fn_obj.fn()->fn_lit()->body(), *fn_env);
-        return value;
+        auto error = ops::not_fn_error(m_args[base]);
+        m_args.resize(base);
+        return error;
     }
-    return not_fn_error(fn);
-}
 
-static std::unique_ptr<env::Environment> extend_fn_env(const FunctionObject&      fn_obj,
-                                                       const std::vector<Object>& args)
-{
-    auto fn_env = std::make_unique<env::Environment>(fn_obj.env());
+    const auto* fn_obj = &m_args[base].as<FunctionObject>();
+    const auto* argv   = m_args.data() + base + 1;
+    auto        argc   = m_args.size() - base - 1;
 
-    const auto& node = *fn_obj.fn();  // Step into this to check if m_fn member is deleted.
-    if (auto* params = node.fn_lit()->params(); params)
+    // Each tail call made by the body runs in this loop rather than in a
+    // call of its own, so tail recursion neither grows the CallStack nor
+    // keeps the previous call's Environment alive.
+    for (;;)
     {
-        size_t i = 0;
-        for (const auto& param : *params)
+        const auto* params     = fn_obj->fn()->params();
+        const auto  num_params = params ? params->size() : 0;
+        if (argc != num_params)
         {
-            fn_env->set(param.name(), args[i++]);
+            m_args.resize(base);
+            return ops::wrong_args_error(num_params, argc);
         }
-    }
-    return fn_env;
-}
 
-static bool is_truthy(const Object& obj)
-{
-    switch (obj.m_type)
-    {
-        case ObjectType::Boolean:
-            return std::get<bool>(obj.m_value);
-
-        case ObjectType::Null:
-            return false;
-
-        default:
-            return true;
-    }
-}
-
-static bool is_error(const Object& obj)
-{
-    return obj.m_type == ObjectType::Error;
-}
-
-static Object unknown_op_error(const Object& right)
-{
-    return Object{ObjectType::Error,
-                  std::string("unknown operator: -" + obj::type_to_string(right.m_type))};
-}
+        const auto* fn_lit = fn_obj->fn()->fn_lit();
+        auto*       fn_env = extend_fn_env(*fn_obj, argv);
+        m_args.resize(base);
+        if (!m_calls.push(fn_env))
+        {
+            env::Environment::release(fn_env);
+            return ops::stack_overflow_error(m_calls.max_depth());
+        }
+        m_tail_call.clear();
 
-static Object unknown_op_error(const TokenType& op, const Object& right)
-{
-    return Object{ObjectType::Error,
-                  std::string("unknown operator: " + tok::type_to_string(op)
-                              + obj::type_to_string(right.m_type))};
-}
+        // Everything live is reachable now: the caller's values are rooted
+        // and the arguments are bound in fn_env.
+        gc::heap().safepoint();
 
-static Object unknown_op_error(const TokenType& op, const Object& left, const Object& right)
-{
-    return Object{ObjectType::Error,
-                  std::string("unknown operator: " + obj::type_to_string(left.m_type))
-                    + " " + tok::type_to_string(op) + " " + obj::type_to_string(right.m_type)};
-}
+        auto value = m_calls.run([this, fn_lit, fn_env]() {
+            return eval(*fn_lit->body(), *fn_env);
+        });
 
-static Object type_mismatch_error(const TokenType& op, const Object& left, const Object& right)
-{
-    return Object{ObjectType::Error,
-                  std::string("type mismatch: " + obj::type_to_string(left.m_type))
-                    + " " + tok::type_to_string(op) + " " + obj::type_to_string(right.m_type)};
-}
+        m_calls.pop();
+        env::Environment::release(fn_env);
 
-static Object unknown_ident_error(const ast::Identifier& ident)
-{
-    return Object{ObjectType::Error,
-                  std::string("identifier not found: " + ident.name())};
-}
+        if (m_tail_call.empty())
+        {
+            // A return stops at the function boundary rather than unwinding the caller.
+            value.set_returning(false);
+            return value;
+        }
 
-static Object not_fn_error(const Object& not_fn)
-{
-    return Object{ObjectType::Error,
-                  std::string("not a function: " + obj::type_to_string(not_fn.m_type))};
+        fn_obj = &m_tail_call.front().as<FunctionObject>();
+        argv   = m_tail_call.data() + 1;
+        argc   = m_tail_call.size() - 1;
+    }
 }
 
 }  // namespace punky::eval
@@ -0,0 +1,283 @@
+#include "punky/FlatResolver.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include <punky/FlatAst.hpp>
+#include <punky/ScopeNames.hpp>
+#include <punky/Symbol.hpp>
+#include <punky/ast.hpp>
+
+namespace punky::resolve
+{
+
+using punky::ast::AstType;
+
+// The FlatAst as mark_tail() sees it
+struct FlatView
+{
+    using Expr = ast::NodeId;
+
+    const ast::FlatAst* m_ast;
+
+    [[nodiscard]] AstType kind(Expr expr) const { return m_ast->kind(expr); }
+
+    [[nodiscard]] ast::NodeId consequence(Expr expr) const { return m_ast->consequence(expr); }
+    [[nodiscard]] ast::NodeId alternative(Expr expr) const { return m_ast->alternative(expr); }
+
+    [[nodiscard]] auto last_expression(ast::NodeId block) const -> std::optional<Expr>
+    {
+        if (block == ast::NO_NODE)
+            return std::nullopt;
+
+        const auto stmts = m_ast->statements(block);
+        if (stmts.empty() || m_ast->kind(stmts.back()) != AstType::ExpressionStmt)
+            return std::nullopt;
+        return m_ast->expression(stmts.back());
+    }
+};
+
+FlatResolver::FlatResolver() :
+  m_scopes(1)
+{}
+
+void FlatResolver::resolve(const ast::FlatAst& ast)
+{
+    m_ast = &ast;
+    m_spans.assign(ast.size(), Span{0, 0});
+    m_bindings.clear();
+    m_tails.assign(ast.size(), false);
+    m_functions.clear();
+
+    for (const auto stmt : ast.statements(ast.root()))
+        resolve_statement(stmt);
+    resolve_deferred();
+}
+
+auto FlatResolver::reads(ast::NodeId ident) const -> BindingList
+{
+    const auto span = m_spans[ident];
+    return BindingList{m_bindings.data() + span.m_start, span.m_size};
+}
+
+auto FlatResolver::target(ast::NodeId let) const -> const Binding&
+{
+    return m_bindings[m_spans[let].m_start];
+}
+
+auto FlatResolver::function(ast::NodeId fn) const -> const FlatFunction&
+{
+    return m_functions.at(fn);
+}
+
+void FlatResolver::resolve_statement(ast::NodeId stmt)
+{
+    switch (m_ast->kind(stmt))
+    {
+        case AstType::ExpressionStmt:
+            resolve_expression(m_ast->expression(stmt));
+            break;
+
+        case AstType::ReturnStmt:
+            resolve_expression(m_ast->expression(stmt));
+
+            // As in Resolver, a return in a function ends its call
+            if (m_scopes.size() > 1)
+                mark_tail_calls(m_ast->expression(stmt));
+            break;
+
+        case AstType::LetStmt:
+        {
+            // As in Resolver, a function literal bound by the let may count
+            // on the name from its first call
+            const auto value = m_ast->let_value(stmt);
+            if (m_ast->kind(value) == AstType::Function)
+                m_scopes.back().m_deferred.push_back(Deferred{value, m_scopes.back().m_position + 1});
+            else
+                resolve_expression(value);
+
+            declare(stmt);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void FlatResolver::resolve_expression(ast::NodeId expr)
+{
+    switch (m_ast->kind(expr))
+    {
+        case AstType::Identifier:
+            lookup(expr);
+            break;
+
+        case AstType::Prefix:
+            resolve_expression(m_ast->right(expr));
+            break;
+
+        case AstType::Infix:
+            resolve_expression(m_ast->left(expr));
+            resolve_expression(m_ast->right(expr));
+            break;
+
+        case AstType::If:
+        {
+            // Blocks do not open a scope, their lets bind in the enclosing function
+            resolve_expression(m_ast->condition(expr));
+            for (const auto stmt : m_ast->statements(m_ast->consequence(expr)))
+                resolve_statement(stmt);
+            if (const auto alt = m_ast->alternative(expr); alt != ast::NO_NODE)
+            {
+                for (const auto stmt : m_ast->statements(alt))
+                    resolve_statement(stmt);
+            }
+            break;
+        }
+
+        case AstType::Function:
+            m_scopes.back().m_deferred.push_back(Deferred{expr, m_scopes.back().m_position});
+            break;
+
+        case AstType::Call:
+            resolve_expression(m_ast->function(expr));
+            for (const auto arg : m_ast->arguments(expr))
+                resolve_expression(arg);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void FlatResolver::resolve_function(const Deferred& deferred)
+{
+    const auto fn = deferred.m_fn;
+
+    // Indexed, as resolving a function pushes onto m_scopes
+    const auto level = m_scopes.size();
+    m_scopes.emplace_back();
+    m_scopes[level].m_entry_position = deferred.m_position;
+
+    for (const auto param : m_ast->params(fn))
+        m_scopes[level].declare_param(param);
+
+    const auto body = m_ast->body(fn);
+    for (const auto stmt : m_ast->statements(body))
+    {
+        resolve_statement(stmt);
+
+        const auto is_let = m_ast->kind(stmt) == AstType::LetStmt;
+        m_scopes[level].end_statement(is_let ? std::optional{m_ast->let_symbol(stmt)} : std::nullopt);
+    }
+    if (const auto last = FlatView{m_ast}.last_expression(body); last)
+        mark_tail_calls(*last);
+
+    m_scopes[level].m_fn.m_cells.resize(m_scopes[level].m_num_slots);
+    for (const auto& read : m_scopes[level].m_reads)
+        bind_read(read);
+
+    resolve_deferred();
+
+    auto& scope             = m_scopes[level];
+    scope.m_fn.m_num_locals = scope.m_num_slots;
+    m_functions[fn]         = std::move(scope.m_fn);
+    m_scopes.pop_back();
+}
+
+void FlatResolver::resolve_deferred()
+{
+    // Indexed, as resolving a function pushes onto m_scopes
+    const auto level = m_scopes.size() - 1;
+    for (std::size_t i = 0; i < m_scopes[level].m_deferred.size(); ++i)
+        resolve_function(m_scopes[level].m_deferred[i]);
+    m_scopes[level].m_deferred.clear();
+}
+
+void FlatResolver::mark_tail_calls(ast::NodeId expr)
+{
+    mark_tail(FlatView{m_ast}, expr, [this](ast::NodeId call) { m_tails[call] = true; });
+}
+
+void FlatResolver::declare(ast::NodeId let)
+{
+    const auto symbol = m_ast->let_symbol(let);
+
+    auto binding = Binding{Storage::Global, 0};
+    if (m_scopes.size() == 1)
+        binding.m_index = global_slot(symbol);
+    else
+        binding = Binding{Storage::Local, m_scopes.back().declare(symbol).first};
+
+    m_spans[let] = Span{static_cast<std::uint32_t>(m_bindings.size()), 1};
+    m_bindings.push_back(binding);
+}
+
+void FlatResolver::lookup(ast::NodeId ident)
+{
+    if (m_scopes.size() == 1)
+    {
+        m_spans[ident] = Span{static_cast<std::uint32_t>(m_bindings.size()), 1};
+        m_bindings.push_back(Binding{Storage::Global, global_slot(m_ast->symbol(ident))});
+    }
+    else
+        m_scopes.back().m_reads.push_back(Read{ident, m_scopes.back().m_position});
+}
+
+// As Resolver::bind_read(), with the bindings of outer scopes reached
+// through the running closure's free variables
+void FlatResolver::bind_read(const Read& read)
+{
+    const auto symbol  = m_ast->symbol(read.m_ident);
+    const auto current = m_scopes.size() - 1;
+
+    auto& span = m_spans[read.m_ident];
+    span       = Span{static_cast<std::uint32_t>(m_bindings.size()), 0};
+
+    const auto found = [&](std::size_t level, std::uint32_t slot) {
+        ++span.m_size;
+        m_bindings.push_back(level == current ? Binding{Storage::Local, slot}
+                                              : Binding{Storage::Free, capture(level, slot, current)});
+    };
+
+    if (!find_bindings(m_scopes, symbol, read.m_position, found))
+    {
+        ++span.m_size;
+        m_bindings.push_back(Binding{Storage::Global, global_slot(symbol)});
+    }
+}
+
+// The free variable of the function at level from that holds the Cell of
+// slot at level, captured in turn by every function in between
+auto FlatResolver::capture(std::size_t level, std::uint32_t slot, std::size_t from) -> std::uint32_t
+{
+    const auto key = (static_cast<std::uint64_t>(level) << 32) | slot;
+    if (const auto res = m_scopes[from].m_free.find(key); res != m_scopes[from].m_free.cend())
+        return res->second;
+
+    auto source = Binding{Storage::Local, slot};
+    if (from - 1 == level)
+        m_scopes[level].m_fn.m_cells[slot] = true;
+    else
+        source = Binding{Storage::Free, capture(level, slot, from - 1)};
+
+    auto&      captures = m_scopes[from].m_fn.m_captures;
+    const auto index    = static_cast<std::uint32_t>(captures.size());
+    captures.push_back(source);
+    m_scopes[from].m_free.emplace(key, index);
+    return index;
+}
+
+// Unknown names become globals that may be bound later
+auto FlatResolver::global_slot(sym::SymbolId symbol) -> std::uint32_t
+{
+    const auto [slot, inserted] = m_scopes.front().declare(symbol);
+    if (inserted)
+        m_global_names.push_back(symbol);
+    return slot;
+}
+
+}  // namespace punky::resolve
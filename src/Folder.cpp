@@ -0,0 +1,390 @@
+#include "punky/Folder.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <punky/Arena.hpp>
+#include <punky/FlatAst.hpp>
+#include <punky/Object.hpp>
+#include <punky/Token.hpp>
+#include <punky/ast.hpp>
+#include <punky/operators.hpp>
+
+namespace punky::opt
+{
+
+using punky::ast::AstType;
+using punky::obj::Object;
+using punky::obj::ObjectType;
+using punky::tok::TokenType;
+
+static auto constant(const ast::ExprNode& expr) -> std::optional<Object>;
+static bool declares(const ast::BlockStmt* blk);
+static bool declares(const ast::ExprNode& expr);
+
+// The rules both the Folder and fold() follow. An operator is applied to
+// constant operands by punky::ops, as at run time, unless that fails.
+static auto prefix_value(TokenType op, const std::optional<Object>& right) -> std::optional<Object>
+{
+    if (!right)
+        return std::nullopt;
+
+    auto value = ops::prefix(op, *right);
+    return ops::is_error(value) ? std::nullopt : std::optional{value};
+}
+
+static auto infix_value(TokenType op, const std::optional<Object>& left, const std::optional<Object>& right)
+  -> std::optional<Object>
+{
+    if (!left || !right)
+        return std::nullopt;
+
+    auto value = ops::infix(op, *left, *right);
+    return ops::is_error(value) ? std::nullopt : std::optional{value};
+}
+
+// The branch an if with a constant condition takes, where a missing one is
+// none. A branch is only dropped when it binds no names: lets in an if block
+// bind in the enclosing function's scope, which the Resolver sees either way.
+template <typename Block, typename Declares>
+static auto choose_branch(const std::optional<Object>& cond, Block cons, Block alt, Block none,
+                          Declares declares) -> std::optional<Block>
+{
+    if (!cond)
+        return std::nullopt;
+
+    const auto taken = ops::is_truthy(*cond);
+    const auto dead  = taken ? alt : cons;
+    if (dead != none && declares(dead))
+        return std::nullopt;
+    return taken ? cons : alt;
+}
+
+Folder::Folder(ast::Arena& arena) :
+  m_arena{&arena}
+{}
+
+void Folder::fold(ast::Program& prog)
+{
+    fold_block(prog.statements());
+}
+
+void Folder::fold_block(const ast::StmtNodeVector& stmts)
+{
+    for (const auto& stmt : stmts)
+        fold_statement(*stmt);
+}
+
+void Folder::fold_statement(ast::StmtNode& stmt)
+{
+    switch (stmt.ast_type())
+    {
+        case AstType::ExpressionStmt:
+        {
+            auto& expr_stmt = static_cast<ast::ExpressionStmt&>(stmt);
+            expr_stmt.set_expression(fold_expression(expr_stmt.expression()));
+            break;
+        }
+
+        case AstType::LetStmt:
+        {
+            auto& let_stmt = static_cast<ast::LetStmt&>(stmt);
+            let_stmt.set_rhs(fold_expression(let_stmt.rhs()));
+            break;
+        }
+
+        case AstType::ReturnStmt:
+        {
+            auto& ret_stmt = static_cast<ast::ReturnStmt&>(stmt);
+            ret_stmt.set_ret_expr(fold_expression(ret_stmt.ret_expr()));
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void Folder::fold_function(ast::FunctionLiteral& fn)
+{
+    fn.keep_source();
+    fold_block(fn.body()->block_stmt()->statements());
+}
+
+auto Folder::fold_expression(ast::ExprNode* expr) -> ast::ExprNode*
+{
+    switch (expr->ast_type())
+    {
+        case AstType::Prefix:
+            return fold_prefix(static_cast<ast::PrefixExpression&>(*expr));
+
+        case AstType::Infix:
+            return fold_infix(static_cast<ast::InfixExpression&>(*expr));
+
+        case AstType::If:
+            return fold_if(static_cast<ast::IfExpression&>(*expr));
+
+        case AstType::Function:
+            fold_function(static_cast<ast::FunctionLiteral&>(*expr));
+            return expr;
+
+        case AstType::Call:
+        {
+            auto& call = static_cast<ast::CallExpression&>(*expr);
+            call.set_function(fold_expression(call.function()));
+            if (auto* args = call.arguments())
+                for (auto& arg : *args)
+                    arg = fold_expression(arg);
+            return expr;
+        }
+
+        default:
+            return expr;
+    }
+}
+
+auto Folder::fold_prefix(ast::PrefixExpression& expr) -> ast::ExprNode*
+{
+    expr.set_right(fold_expression(expr.right()));
+
+    if (const auto value = prefix_value(expr.type(), constant(*expr.right())))
+        return make_literal(*value);
+    return &expr;
+}
+
+auto Folder::fold_infix(ast::InfixExpression& expr) -> ast::ExprNode*
+{
+    expr.set_left(fold_expression(expr.left()));
+    expr.set_right(fold_expression(expr.right()));
+
+    if (const auto value = infix_value(expr.type(), constant(*expr.left()), constant(*expr.right())))
+        return make_literal(*value);
+    return &expr;
+}
+
+auto Folder::fold_if(ast::IfExpression& expr) -> ast::ExprNode*
+{
+    expr.set_condition(fold_expression(expr.condition()));
+    fold_block(expr.consequence()->statements());
+    if (auto* alt = expr.alternative())
+        fold_block(alt->statements());
+
+    const auto branch = choose_branch(constant(*expr.condition()), expr.consequence(), expr.alternative(),
+                                      static_cast<ast::BlockStmt*>(nullptr),
+                                      [](const ast::BlockStmt* blk) { return declares(blk); });
+    if (!branch)
+        return &expr;
+
+    auto*      live  = *branch;
+    const auto taken = live == expr.consequence();
+
+    // A single expression is the value of its block, so it replaces the if
+    if (live && live->statements().size() == 1
+        && live->statements().front()->ast_type() == AstType::ExpressionStmt)
+        return live->statements().front()->expr_stmt()->expression();
+
+    if (!live)
+    {
+        // Evaluates to null without running anything
+        expr.set_branches(m_arena->make<ast::BlockStmt>(
+                            tok::make_token(TokenType::LeftBrace, "{")),
+                          std::nullopt);
+        return &expr;
+    }
+
+    if (!taken)
+        expr.set_condition(make_literal(Object{true}));
+    expr.set_branches(live, std::nullopt);
+    return &expr;
+}
+
+auto Folder::make_literal(const Object& value) -> ast::ExprNode*
+{
+    if (value.type() == ObjectType::Int)
+    {
+        const auto literal = m_arena->copy_source(std::to_string(value.as_int()));
+        return m_arena->make<ast::IntLiteral>(tok::make_token(TokenType::Int, literal),
+                                              value.as_int());
+    }
+
+    return value.as_bool()
+             ? m_arena->make<ast::Boolean>(tok::make_token(TokenType::True, "true"), true)
+             : m_arena->make<ast::Boolean>(tok::make_token(TokenType::False, "false"), false);
+}
+
+static auto constant(const ast::ExprNode& expr) -> std::optional<Object>
+{
+    switch (expr.ast_type())
+    {
+        case AstType::Int:
+            return Object{expr.int_lit()->value()};
+
+        case AstType::Bool:
+            return Object{expr.boolean()->value()};
+
+        default:
+            return std::nullopt;
+    }
+}
+
+static bool declares(const ast::BlockStmt* blk)
+{
+    if (!blk)
+        return false;
+
+    for (const auto& stmt : blk->statements())
+    {
+        switch (stmt->ast_type())
+        {
+            case AstType::LetStmt:
+                return true;
+
+            case AstType::ExpressionStmt:
+                if (declares(*stmt->expr_stmt()->expression()))
+                    return true;
+                break;
+
+            case AstType::ReturnStmt:
+                if (declares(*stmt->return_stmt()->ret_expr()))
+                    return true;
+                break;
+
+            default:
+                break;
+        }
+    }
+    return false;
+}
+
+// Function literals are left out, their lets bind in their own scope
+static bool declares(const ast::ExprNode& expr)
+{
+    switch (expr.ast_type())
+    {
+        case AstType::Prefix:
+            return declares(*expr.prefix_expr()->right());
+
+        case AstType::Infix:
+            return declares(*expr.infix_expr()->left())
+                   || declares(*expr.infix_expr()->right());
+
+        case AstType::If:
+            return declares(*expr.if_expr()->condition())
+                   || declares(expr.if_expr()->consequence())
+                   || declares(expr.if_expr()->alternative());
+
+        case AstType::Call:
+        {
+            const auto* call = expr.call_expr();
+            if (declares(*call->function()))
+                return true;
+            if (const auto* args = call->arguments())
+                for (const auto& arg : *args)
+                    if (declares(*arg))
+                        return true;
+            return false;
+        }
+
+        default:
+            return false;
+    }
+}
+
+auto fold(const ast::FlatAst& ast) -> FlatFolds
+{
+    auto folds = FlatFolds{std::vector<std::optional<Object>>(ast.size()),
+                           std::vector<bool>(ast.size())};
+
+    auto& values   = folds.m_values;
+    auto& declares = folds.m_declares;
+
+    const auto any_declares = [&declares](ast::NodeList nodes) {
+        for (const auto node : nodes)
+            if (declares[node])
+                return true;
+        return false;
+    };
+
+    for (ast::NodeId node = 0; node < ast.size(); ++node)
+    {
+        switch (ast.kind(node))
+        {
+            case AstType::Prog:
+            case AstType::BlockStmt:
+                declares[node] = any_declares(ast.statements(node));
+                break;
+
+            case AstType::ExpressionStmt:
+            case AstType::ReturnStmt:
+                declares[node] = declares[ast.expression(node)];
+                break;
+
+            case AstType::LetStmt:
+                declares[node] = true;
+                break;
+
+            case AstType::Int:
+                values[node] = Object{ast.int_value(node)};
+                break;
+
+            case AstType::Bool:
+                values[node] = Object{ast.bool_value(node)};
+                break;
+
+            case AstType::Prefix:
+            {
+                const auto right = ast.right(node);
+                declares[node]   = declares[right];
+                values[node]     = prefix_value(ast.op(node), values[right]);
+                break;
+            }
+
+            case AstType::Infix:
+            {
+                const auto left  = ast.left(node);
+                const auto right = ast.right(node);
+                declares[node]   = declares[left] || declares[right];
+                values[node]     = infix_value(ast.op(node), values[left], values[right]);
+                break;
+            }
+
+            case AstType::If:
+            {
+                const auto cond = ast.condition(node);
+                const auto cons = ast.consequence(node);
+                const auto alt  = ast.alternative(node);
+                declares[node]  = declares[cond] || declares[cons] || (alt != ast::NO_NODE && declares[alt]);
+
+                // As fold_if(): a single constant expression is the value of
+                // the live branch, and so of the if
+                const auto live = live_branch(ast, folds, node);
+                if (!live || *live == ast::NO_NODE)
+                    break;
+
+                const auto stmts = ast.statements(*live);
+                if (stmts.size() == 1 && ast.kind(stmts[0]) == AstType::ExpressionStmt)
+                    values[node] = values[ast.expression(stmts[0])];
+                break;
+            }
+
+            case AstType::Call:
+                declares[node] = declares[ast.function(node)] || any_declares(ast.arguments(node));
+                break;
+
+            // Function literals are left out, their lets bind in their own scope
+            default:
+                break;
+        }
+    }
+    return folds;
+}
+
+auto live_branch(const ast::FlatAst& ast, const FlatFolds& folds, ast::NodeId if_expr) -> std::optional<ast::NodeId>
+{
+    return choose_branch(folds.m_values[ast.condition(if_expr)], ast.consequence(if_expr), ast.alternative(if_expr),
+                         ast::NO_NODE, [&folds](ast::NodeId blk) { return folds.m_declares[blk]; });
+}
+
+}  // namespace punky::opt
@@ -0,0 +1,387 @@
+#include "punky/Heap.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <punky/Object.hpp>
+
+namespace punky::gc
+{
+
+using punky::obj::HeapObject;
+
+void Tracer::mark(const HeapObject* obj)
+{
+    // Young objects are traced as part of the nursery
+    if (obj && !obj->m_marked && !obj->m_young)
+    {
+        obj->m_marked = true;
+        m_gray.push_back(obj);
+    }
+}
+
+Root::Root(const obj::Object& obj) :
+  Root{obj.is_heap() ? obj.heap_object() : nullptr}
+{}
+
+// Roots with nothing to keep alive are never registered, so rooting an int
+// costs a branch.
+Root::Root(const HeapObject* obj) :
+  m_obj{obj}
+{
+    if (m_obj)
+        heap().add_roots(*this);
+}
+
+Root::Root(const std::vector<obj::Object>& objs) :
+  m_objs{&objs}
+{
+    heap().add_roots(*this);
+}
+
+Root::~Root()
+{
+    if (m_obj || m_objs)
+        heap().remove_roots(*this);
+}
+
+void Root::trace(Tracer& tracer) const
+{
+    tracer.mark(m_obj);
+    if (m_objs)
+    {
+        for (const auto& obj : *m_objs)
+            tracer.mark(obj);
+    }
+}
+
+auto Heap::Page::cell(std::size_t index) -> std::byte*
+{
+    return reinterpret_cast<std::byte*>(this) + PAGE_HEADER_SIZE + index * m_cell_size;
+}
+
+Heap::~Heap()
+{
+    for (auto& cls : m_classes)
+    {
+        for (auto* page : cls.m_pages)
+        {
+            for (std::size_t i = 0; i < page->m_num_cells; ++i)
+            {
+                if (page->m_used[i])
+                    reinterpret_cast<HeapObject*>(page->cell(i))->~HeapObject();
+            }
+            page->~Page();
+            std::free(page);
+        }
+    }
+
+    for (const auto& large : m_large)
+    {
+        large.m_obj->~HeapObject();
+        ::operator delete(large.m_obj);
+    }
+
+    for (auto it = m_young.rbegin(); it != m_young.rend(); ++it)
+        it->m_obj->~HeapObject();
+    for (auto* chunk : m_young_chunks)
+        std::free(chunk);
+}
+
+void Heap::add_roots(const RootSet& roots)
+{
+    m_roots.push_back(&roots);
+}
+
+// Roots mostly come and go in LIFO order, so the search is usually one step
+void Heap::remove_roots(const RootSet& roots)
+{
+    const auto it = std::find(m_roots.rbegin(), m_roots.rend(), &roots);
+    if (it != m_roots.rend())
+        m_roots.erase(std::next(it).base());
+}
+
+void Heap::set_threshold(std::size_t bytes)
+{
+    m_threshold = bytes;
+    m_next_gc   = bytes == 0 ? 0 : std::max(bytes, m_stats.m_live_bytes);
+}
+
+void Heap::collect()
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    mark();
+    sweep();
+
+    const auto pause = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start);
+
+    ++m_stats.m_collections;
+    m_stats.m_last_pause = pause;
+    m_stats.m_max_pause  = std::max(m_stats.m_max_pause, pause);
+    m_stats.m_total_pause += pause;
+
+    m_allocated_since_gc = 0;
+    m_next_gc            = m_threshold == 0 ? 0 : std::max(m_threshold, m_stats.m_live_bytes);
+}
+
+void Heap::mark()
+{
+    for (const auto* roots : m_roots)
+        roots->trace(m_tracer);
+    for (const auto& young : m_young)
+        young.m_obj->trace(m_tracer);
+
+    // An explicit worklist, since a chain of Environments can be arbitrarily long
+    while (!m_tracer.m_gray.empty())
+    {
+        const auto* obj = m_tracer.m_gray.back();
+        m_tracer.m_gray.pop_back();
+        obj->trace(m_tracer);
+    }
+}
+
+void Heap::sweep()
+{
+    for (std::size_t cls = 0; cls < m_classes.size(); ++cls)
+        sweep_class(cls);
+
+    auto live = std::size_t{};
+    for (auto& large : m_large)
+    {
+        if (large.m_obj->m_marked)
+        {
+            large.m_obj->m_marked = false;
+            m_large[live++]       = large;
+            continue;
+        }
+
+        large.m_obj->~HeapObject();
+        ::operator delete(large.m_obj);
+
+        m_stats.m_live_bytes -= large.m_size;
+        m_stats.m_freed_bytes += large.m_size;
+        --m_stats.m_live_objects;
+    }
+    m_large.resize(live);
+}
+
+// Rebuilds the class's free list from scratch, lowest address first, and
+// gives pages with nothing left on them back to the system. One empty page
+// is kept, so a class that is briefly unused does not map a page per cycle.
+void Heap::sweep_class(std::size_t size_class)
+{
+    auto& cls = m_classes[size_class];
+
+    cls.m_free       = nullptr;
+    auto** tail      = &cls.m_free;
+    auto   num_kept  = std::size_t{};
+    auto   kept_free = false;
+
+    for (auto* page : cls.m_pages)
+    {
+        auto* const page_free = tail;
+        auto        num_live  = std::size_t{};
+
+        for (std::size_t i = 0; i < page->m_num_cells; ++i)
+        {
+            auto* cell = page->cell(i);
+            if (page->m_used[i])
+            {
+                auto* obj = reinterpret_cast<HeapObject*>(cell);
+                if (obj->m_marked)
+                {
+                    obj->m_marked = false;
+                    ++num_live;
+                    continue;
+                }
+
+                obj->~HeapObject();
+                page->m_used.reset(i);
+
+                m_stats.m_live_bytes -= page->m_cell_size;
+                m_stats.m_freed_bytes += page->m_cell_size;
+                --m_stats.m_live_objects;
+            }
+
+            auto* free = new (cell) FreeCell{nullptr};
+            *tail      = free;
+            tail       = &free->m_next;
+        }
+
+        if (num_live == 0 && std::exchange(kept_free, true))
+        {
+            // Unlink the cells this page just added
+            *page_free = nullptr;
+            tail       = page_free;
+
+            page->~Page();
+            std::free(page);
+            --m_stats.m_pages;
+            continue;
+        }
+
+        cls.m_pages[num_kept++] = page;
+    }
+    cls.m_pages.resize(num_kept);
+}
+
+auto Heap::allocate(std::size_t size) -> void*
+{
+    if (size > MAX_CELL_SIZE)
+        return ::operator new(size);
+
+    auto& cls = m_classes[size_class(size)];
+    if (!cls.m_free)
+        add_page(size_class(size));
+
+    auto* cell = cls.m_free;
+    cls.m_free = cell->m_next;
+    return cell;
+}
+
+// Cells are only marked used once their object is constructed, so sweeping
+// never destroys one that is not.
+void Heap::commit(HeapObject* obj, std::size_t size)
+{
+    if (size > MAX_CELL_SIZE)
+    {
+        m_large.push_back(LargeObject{obj, size});
+    }
+    else
+    {
+        auto* page = page_of(obj);
+        page->m_used.set(static_cast<std::size_t>(reinterpret_cast<std::byte*>(obj) - page->cell(0))
+                         / page->m_cell_size);
+        size = page->m_cell_size;
+    }
+
+    m_allocated_since_gc += size;
+    m_stats.m_live_bytes += size;
+    m_stats.m_allocated_bytes += size;
+    ++m_stats.m_allocated_objects;
+    ++m_stats.m_live_objects;
+}
+
+auto Heap::allocate_young(std::size_t size) -> void*
+{
+    size = (size + CELL_ALIGN - 1) / CELL_ALIGN * CELL_ALIGN;
+    if (size > YOUNG_CHUNK_SIZE)
+        return nullptr;
+
+    if (static_cast<std::size_t>(m_young_end - m_young_top) < size)
+    {
+        // Only the very first chunk starts out without any memory
+        if (m_young_top)
+            ++m_young_chunk;
+
+        if (m_young_chunk == m_young_chunks.size())
+        {
+            auto* memory = static_cast<std::byte*>(std::aligned_alloc(CELL_ALIGN, YOUNG_CHUNK_SIZE));
+            if (!memory)
+                throw std::bad_alloc{};
+            m_young_chunks.push_back(memory);
+        }
+
+        m_young_top = m_young_chunks[m_young_chunk];
+        m_young_end = m_young_top + YOUNG_CHUNK_SIZE;
+    }
+
+    auto* memory = m_young_top;
+    m_young_top += size;
+    m_stats.m_young_bytes += size;
+    return memory;
+}
+
+void Heap::commit_young(HeapObject* obj)
+{
+    obj->m_young = true;
+    m_young.push_back(YoungObject{obj, m_young_chunk});
+    ++m_stats.m_young_objects;
+}
+
+void Heap::release_young(HeapObject* obj)
+{
+    for (;;)
+    {
+        const auto young = m_young.back();
+        m_young.pop_back();
+        young.m_obj->~HeapObject();
+
+        if (young.m_obj == obj)
+        {
+            m_young_chunk = young.m_chunk;
+            m_young_top   = reinterpret_cast<std::byte*>(obj);
+            m_young_end   = m_young_chunks[m_young_chunk] + YOUNG_CHUNK_SIZE;
+            return;
+        }
+    }
+}
+
+void Heap::add_page(std::size_t size_class)
+{
+    auto* memory = std::aligned_alloc(PAGE_SIZE, PAGE_SIZE);
+    if (!memory)
+        throw std::bad_alloc{};
+
+    const auto cell_size = SIZE_CLASSES[size_class];
+    auto*      page      = new (memory) Page{cell_size, (PAGE_SIZE - PAGE_HEADER_SIZE) / cell_size, {}};
+
+    auto& cls = m_classes[size_class];
+    cls.m_pages.push_back(page);
+    ++m_stats.m_pages;
+
+    // Pushed back to front, so cells are handed out in address order
+    for (auto i = page->m_num_cells; i-- > 0;)
+        cls.m_free = new (page->cell(i)) FreeCell{cls.m_free};
+}
+
+auto Heap::size_class(std::size_t size) -> std::size_t
+{
+    std::size_t cls = 0;
+    while (SIZE_CLASSES[cls] < size)
+        ++cls;
+    return cls;
+}
+
+auto Heap::page_of(const void* cell) -> Page*
+{
+    return reinterpret_cast<Page*>(reinterpret_cast<std::uintptr_t>(cell) & ~(PAGE_SIZE - 1));
+}
+
+std::string to_string(const HeapStats& stats)
+{
+    const auto micros = [](std::chrono::nanoseconds ns) {
+        return std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(ns).count())
+               + "us";
+    };
+
+    return "collections: " + std::to_string(stats.m_collections)
+           + "\nlive: " + std::to_string(stats.m_live_objects) + " objects, "
+           + std::to_string(stats.m_live_bytes) + " bytes in "
+           + std::to_string(stats.m_pages) + " pages"
+           + "\nallocated: " + std::to_string(stats.m_allocated_objects) + " objects, "
+           + std::to_string(stats.m_allocated_bytes) + " bytes, freed: "
+           + std::to_string(stats.m_freed_bytes) + " bytes, young: "
+           + std::to_string(stats.m_young_objects) + " objects, "
+           + std::to_string(stats.m_young_bytes) + " bytes"
+           + "\npause: last " + micros(stats.m_last_pause) + ", max " + micros(stats.m_max_pause)
+           + ", total " + micros(stats.m_total_pause);
+}
+
+auto heap() -> Heap&
+{
+    static Heap the_heap;
+    return the_heap;
+}
+
+}  // namespace punky::gc
@@ -1,9 +1,10 @@
 #include "punky/Lexer.hpp"
 
-#include <iterator>
+#include <cstddef>
 #include <optional>
-#include <string>
+#include <string_view>
 
+#include <punky/Symbol.hpp>
 #include <punky/Token.hpp>
 #include <punky/utils.hpp>
 
@@ -12,12 +13,11 @@ namespace punky::lex
 
 using punky::tok::TokenType;
 
-static auto token_type(const std::string& tok) -> TokenType;
+static constexpr auto token_type(std::string_view word) -> TokenType;
 
-Lexer::Lexer(std::string line) :
-  m_line{std::move(line)},
-  m_curr_it{m_line.cbegin()},
-  m_curr_char{*m_curr_it}
+Lexer::Lexer(std::string_view source) :
+  m_source{source},
+  m_curr_char{source.empty() ? '\0' : source.front()}
 {
 }
 
@@ -64,10 +64,11 @@ Token Lexer::next_token()
         default:
             if (utils::is_letter(m_curr_char))
             {
-                auto       ident = tokenize_identifier();
+                const auto ident = tokenize_identifier();
                 const auto type  = token_type(ident);
-                return type == TokenType::Identifier ? make_token(type, std::move(ident))
-                                                     : make_token(type, std::nullopt);
+                return type == TokenType::Identifier
+                         ? make_token(type, ident, sym::symbols().intern(ident))
+                         : make_token(type, std::nullopt);
             }
             else if (utils::is_digit(m_curr_char))
                 return make_token(TokenType::Int, tokenize_integer());
@@ -82,61 +83,101 @@ Token Lexer::next_token()
 
 bool Lexer::next_eof() const
 {
-    return std::next(m_curr_it) == m_line.cend();
+    return m_curr_pos + 1 >= m_source.size();
 }
 
 void Lexer::consume()
 {
     if (!next_eof())
-        m_curr_char = *(++m_curr_it);
+        m_curr_char = m_source[++m_curr_pos];
     else
+    {
+        m_curr_pos  = m_source.size();
         m_curr_char = 0;
+    }
+}
+
+void Lexer::seek(std::size_t pos)
+{
+    m_curr_pos  = pos;
+    m_curr_char = pos < m_source.size() ? m_source[pos] : '\0';
 }
 
 auto Lexer::peek() const -> std::optional<char>
 {
     if (!next_eof())
-        return *std::next(m_curr_it);
+        return m_source[m_curr_pos + 1];
     return std::nullopt;
 }
 
+// A comment runs from "//" to the end of its line
 void Lexer::skip_whitespace()
 {
-    while (utils::is_whitespace(m_curr_char))
-        consume();
+    seek(utils::skip_whitespace(m_source, m_curr_pos));
+    while (m_curr_char == '/' && peek() == '/')
+    {
+        const auto line_end = m_source.find('\n', m_curr_pos);
+        seek(line_end == std::string_view::npos ? m_source.size() : line_end);
+        seek(utils::skip_whitespace(m_source, m_curr_pos));
+    }
 }
 
-std::string Lexer::tokenize_identifier()
+std::string_view Lexer::tokenize_identifier()
 {
-    const auto ident_begin = m_curr_it;
-    while (utils::is_letter(m_curr_char))
-        consume();
-    return std::string{ident_begin, m_curr_it};
+    const auto ident_begin = m_curr_pos;
+    seek(utils::skip_letters(m_source, m_curr_pos));
+    return m_source.substr(ident_begin, m_curr_pos - ident_begin);
 }
 
-std::string Lexer::tokenize_integer()
+std::string_view Lexer::tokenize_integer()
 {
-    const auto num_begin = m_curr_it;
-    while (utils::is_digit(m_curr_char))
-        consume();
-    return std::string{num_begin, m_curr_it};
+    const auto num_begin = m_curr_pos;
+    seek(utils::skip_digits(m_source, m_curr_pos));
+    return m_source.substr(num_begin, m_curr_pos - num_begin);
 }
 
-static auto token_type(const std::string& tok) -> TokenType
+// Dispatches on length and first character, so most identifiers are told
+// apart from every keyword without comparing a single string.
+static constexpr auto token_type(std::string_view word) -> TokenType
 {
-    static const std::unordered_map<std::string, TokenType> M_KEYWORDS{
-      {"fn", TokenType::Func},
-      {"let", TokenType::Let},
-      {"true", TokenType::True},
-      {"false", TokenType::False},
-      {"if", TokenType::If},
-      {"else", TokenType::Else},
-      {"return", TokenType::Return},
-    };
-
-    if (const auto res = M_KEYWORDS.find(tok); res != M_KEYWORDS.cend())
-        return res->second;
+    switch (word.size())
+    {
+        case 2:
+            if (word == "fn")
+                return TokenType::Func;
+            if (word == "if")
+                return TokenType::If;
+            break;
+
+        case 3:
+            if (word == "let")
+                return TokenType::Let;
+            break;
+
+        case 4:
+            if (word[0] == 't' && word == "true")
+                return TokenType::True;
+            if (word[0] == 'e' && word == "else")
+                return TokenType::Else;
+            break;
+
+        case 5:
+            if (word == "false")
+                return TokenType::False;
+            break;
+
+        case 6:
+            if (word == "return")
+                return TokenType::Return;
+            break;
+
+        default:
+            break;
+    }
     return TokenType::Identifier;
 }
 
+static_assert(token_type("return") == TokenType::Return);
+static_assert(token_type("returns") == TokenType::Identifier);
+
 }  // namespace punky::lex
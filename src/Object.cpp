@@ -1,32 +1,91 @@
 #include "punky/Object.hpp"
 
-#include <any>
+#include <cstddef>
 #include <string>
-#include <variant>
+#include <utility>
+#include <vector>
 
+#include <punky/CObject.hpp>
+#include <punky/Environment.hpp>
+#include <punky/FObject.hpp>
+#include <punky/Heap.hpp>
 #include <punky/ast.hpp>
 
 namespace punky::obj
 {
 
+Object make_error(std::string message)
+{
+    return Object{ObjectType::Error, gc::heap().make<ErrorObject>(std::move(message))};
+}
+
+Object make_function(const ast::FunctionLiteral* fn, env::Environment* fn_env)
+{
+    return Object{ObjectType::Function, gc::heap().make<FunctionObject>(fn, fn_env)};
+}
+
+Object make_closure(const CompiledFunction* fn, FreeVariables free)
+{
+    return Object{ObjectType::Closure, gc::heap().make<ClosureObject>(fn, std::move(free))};
+}
+
+Object make_cell(Object value)
+{
+    return Object{ObjectType::Cell, gc::heap().make<CellObject>(value)};
+}
+
+env::Environment* extend_fn_env(const FunctionObject& fn_obj, const Object* args)
+{
+    const auto* fn_lit = fn_obj.fn();
+
+    // Unless the body creates a function, nothing can refer to fn_env once
+    // the call returns.
+    auto* fn_env = fn_lit->env_escapes()
+                     ? env::Environment::make(fn_obj.env(), fn_lit->num_locals())
+                     : env::Environment::make_young(fn_obj.env(), fn_lit->num_locals());
+    if (auto* params = fn_lit->params(); params)
+    {
+        std::size_t i = 0;
+        for (const auto& param : *params)
+            fn_env->set(param.slot(), args[i++]);
+    }
+    return fn_env;
+}
+
+void FunctionObject::trace(gc::Tracer& tracer) const
+{
+    tracer.mark(m_fn_env);
+}
+
+void ClosureObject::trace(gc::Tracer& tracer) const
+{
+    for (const auto& free : m_free)
+        tracer.mark(free);
+}
+
+void CellObject::trace(gc::Tracer& tracer) const
+{
+    tracer.mark(m_value);
+}
+
 std::string inspect(const Object& obj)
 {
-    switch (obj.m_type)
+    switch (obj.type())
     {
         case ObjectType::Int:
-            return std::to_string(std::get<int>(obj.m_value));
+            return std::to_string(obj.as_int());
 
         case ObjectType::Boolean:
-            return std::get<bool>(obj.m_value) ? "true" : "false";
-
-        case ObjectType::Return:
-            return inspect(std::any_cast<Object>(obj));
+            return obj.as_bool() ? "true" : "false";
 
         case ObjectType::Error:
-            return std::get<std::string>(obj.m_value);
+            return obj.as<ErrorObject>().message();
 
         case ObjectType::Function:
-            return std::get<FunctionObject>(obj.m_value).fn()->to_string();
+            return obj.as<FunctionObject>().fn()->to_string();
+
+        case ObjectType::Closure:
+            return obj.as<ClosureObject>().fn().source();
 
         case ObjectType::EmptyOut:
             return "";
@@ -49,13 +108,11 @@ std::string type_to_string(const ObjectType& type)
         case ObjectType::Boolean:
             return "boolean";
 
-        case ObjectType::Return:
-            return "return";
-
         case ObjectType::Error:
             return "error";
 
         case ObjectType::Function:
+        case ObjectType::Closure:
             return "fn";
 
         case ObjectType::Null:
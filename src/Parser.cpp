@@ -1,14 +1,16 @@
 #include "punky/Parser.hpp"
 
+#include <array>
 #include <charconv>
-#include <functional>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
-#include <memory>
 #include <optional>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <punky/Arena.hpp>
+#include <punky/FlatAst.hpp>
 #include <punky/Lexer.hpp>
 #include <punky/Token.hpp>
 #include <punky/ast.hpp>
@@ -18,64 +20,134 @@ namespace punky::par
 
 static constexpr auto precedence_lookup(TokenType type) -> PrecedenceLevel;
 
-Parser::Parser(Lexer lex) :
-  m_lex{std::move(lex)}
+static constexpr auto index(TokenType type) -> std::size_t
 {
+    return static_cast<std::size_t>(type);
+}
+
+auto TreeBuilder::let(const Token& tok, const Token& name, Expr value) -> Stmt
+{
+    return m_arena->make<ast::LetStmt>(tok, ast::Identifier{name}, value);
+}
+
+auto TreeBuilder::ret(const Token& tok, Expr value) -> Stmt
+{
+    return m_arena->make<ast::ReturnStmt>(tok, value);
+}
+
+auto TreeBuilder::expr_stmt(const Token& tok, Expr expr) -> Stmt
+{
+    return m_arena->make<ast::ExpressionStmt>(tok, expr);
+}
+
+auto TreeBuilder::identifier(const Token& tok) -> Expr
+{
+    return m_arena->make<ast::Identifier>(tok);
+}
+
+auto TreeBuilder::int_literal(const Token& tok, std::int64_t value) -> Expr
+{
+    return m_arena->make<ast::IntLiteral>(tok, value);
+}
+
+auto TreeBuilder::boolean(const Token& tok, bool value) -> Expr
+{
+    return m_arena->make<ast::Boolean>(tok, value);
+}
+
+auto TreeBuilder::prefix(const Token& tok, Expr right) -> Expr
+{
+    return m_arena->make<ast::PrefixExpression>(tok, right);
+}
+
+auto TreeBuilder::infix(const Token& tok, Expr left, Expr right) -> Expr
+{
+    return m_arena->make<ast::InfixExpression>(tok, left, right);
+}
+
+auto TreeBuilder::if_expr(const Token& tok, Expr condition, Block consequence,
+                          std::optional<Block> alternative) -> Expr
+{
+    return m_arena->make<ast::IfExpression>(tok, condition, consequence, alternative);
+}
+
+auto TreeBuilder::function(const Token& tok, Params params, Block body) -> Expr
+{
+    return m_arena->make<ast::FunctionLiteral>(tok, params, body);
+}
+
+auto TreeBuilder::call(const Token& tok, Expr function, Args args) -> Expr
+{
+    return m_arena->make<ast::CallExpression>(tok, function, args);
+}
+
+auto TreeBuilder::end_params(std::vector<ast::Identifier>& params) -> Params
+{
+    return m_arena->make<std::vector<ast::Identifier>>(std::move(params));
+}
+
+auto TreeBuilder::end_args(ast::ExprNodeVector& args) -> Args
+{
+    return m_arena->make<ast::ExprNodeVector>(std::move(args));
+}
+
+template <typename Builder>
+constexpr std::array<typename BasicParser<Builder>::PrefixParseFn, tok::NUM_TOKEN_TYPES>
+  BasicParser<Builder>::M_PREFIX_PARSE_FNS = [] {
+      std::array<PrefixParseFn, tok::NUM_TOKEN_TYPES> fns{};
+      fns[index(TokenType::Identifier)] = &BasicParser::parse_identifier;
+      fns[index(TokenType::Int)]        = &BasicParser::parse_int_literal;
+      fns[index(TokenType::Bang)]       = &BasicParser::parse_prefix_expression;
+      fns[index(TokenType::Minus)]      = &BasicParser::parse_prefix_expression;
+      fns[index(TokenType::True)]       = &BasicParser::parse_boolean;
+      fns[index(TokenType::False)]      = &BasicParser::parse_boolean;
+      fns[index(TokenType::LeftParen)]  = &BasicParser::parse_grouped_expression;
+      fns[index(TokenType::If)]         = &BasicParser::parse_if_expression;
+      fns[index(TokenType::Func)]       = &BasicParser::parse_function_literal;
+      return fns;
+  }();
+
+template <typename Builder>
+constexpr std::array<typename BasicParser<Builder>::InfixParseFn, tok::NUM_TOKEN_TYPES>
+  BasicParser<Builder>::M_INFIX_PARSE_FNS = [] {
+      std::array<InfixParseFn, tok::NUM_TOKEN_TYPES> fns{};
+      fns[index(TokenType::Plus)]       = &BasicParser::parse_infix_expression;
+      fns[index(TokenType::Minus)]      = &BasicParser::parse_infix_expression;
+      fns[index(TokenType::Asterisk)]   = &BasicParser::parse_infix_expression;
+      fns[index(TokenType::Slash)]      = &BasicParser::parse_infix_expression;
+      fns[index(TokenType::EqualEqual)] = &BasicParser::parse_infix_expression;
+      fns[index(TokenType::BangEqual)]  = &BasicParser::parse_infix_expression;
+      fns[index(TokenType::Less)]       = &BasicParser::parse_infix_expression;
+      fns[index(TokenType::Greater)]    = &BasicParser::parse_infix_expression;
+      fns[index(TokenType::LeftParen)]  = &BasicParser::parse_call_expression;
+      return fns;
+  }();
+
+template <typename Builder>
+BasicParser<Builder>::BasicParser(Lexer lex, typename Builder::Target& target) :
+  m_lex{std::move(lex)},
+  m_build{target}
+{
+    m_build.reserve(m_lex.source_size());
     consume();
     consume();
+}
 
-    register_prefix(TokenType::Identifier, [this] { return parse_identifier(); });
-    register_prefix(TokenType::Int, [this] { return parse_int_literal(); });
-    register_prefix(TokenType::Bang, [this] { return parse_prefix_expression(); });
-    register_prefix(TokenType::Minus, [this] { return parse_prefix_expression(); });
-    register_prefix(TokenType::True, [this] { return parse_boolean(); });
-    register_prefix(TokenType::False, [this] { return parse_boolean(); });
-    register_prefix(TokenType::LeftParen, [this] { return parse_grouped_expression(); });
-    register_prefix(TokenType::If, [this] { return parse_if_expression(); });
-    register_prefix(TokenType::Func, [this] { return parse_function_literal(); });
-
-    register_infix(TokenType::Plus, [this](ast::ExprNodePtr left_expr) {
-        return parse_infix_expression(std::move(left_expr));
-    });
-    register_infix(TokenType::Minus, [this](ast::ExprNodePtr left_expr) {
-        return parse_infix_expression(std::move(left_expr));
-    });
-    register_infix(TokenType::Asterisk, [this](ast::ExprNodePtr left_expr) {
-        return parse_infix_expression(std::move(left_expr));
-    });
-    register_infix(TokenType::Slash, [this](ast::ExprNodePtr left_expr) {
-        return parse_infix_expression(std::move(left_expr));
-    });
-    register_infix(TokenType::EqualEqual, [this](ast::ExprNodePtr left_expr) {
-        return parse_infix_expression(std::move(left_expr));
-    });
-    register_infix(TokenType::BangEqual, [this](ast::ExprNodePtr left_expr) {
-        return parse_infix_expression(std::move(left_expr));
-    });
-    register_infix(TokenType::Less, [this](ast::ExprNodePtr left_expr) {
-        return parse_infix_expression(std::move(left_expr));
-    });
-    register_infix(TokenType::Greater, [this](ast::ExprNodePtr left_expr) {
-        return parse_infix_expression(std::move(left_expr));
-    });
-    register_infix(TokenType::LeftParen, [this](ast::ExprNodePtr function) {
-        return parse_call_expression(std::move(function));
-    });
-}
-
-void Parser::consume()
+template <typename Builder>
+void BasicParser<Builder>::consume()
 {
     std::swap(m_curr_tok, m_peek_tok);
     m_peek_tok = m_lex.next_token();
 }
 
-auto Parser::parse_program() -> std::variant<bool, std::unique_ptr<ast::Program>>
+template <typename Builder>
+auto BasicParser<Builder>::parse_program() -> std::variant<bool, Program>
 {
-    auto prog = std::make_unique<ast::Program>();
+    auto stmts = m_build.begin_program();
     while (!curr_type_is(TokenType::EOS))
     {
-        if (auto stmt = parse_statement(); stmt)
-            prog->push_stmt(std::move(stmt));
+        if (auto stmt = parse_statement(); stmt != Builder::NO_STMT)
+            m_build.push_stmt(stmts, stmt);
         consume();
     }
 
@@ -86,10 +158,11 @@ auto Parser::parse_program() -> std::variant<bool, std::unique_ptr<ast::Program>
             std::cerr << "\t" + error + "\n";
         return false;  // TODO(piyush): Throw instead
     }
-    return prog;
+    return m_build.end_program(stmts);
 }
 
-auto Parser::parse_statement() -> std::unique_ptr<ast::StmtNode>
+template <typename Builder>
+auto BasicParser<Builder>::parse_statement() -> Stmt
 {
     switch (m_curr_tok.m_type)
     {
@@ -102,17 +175,18 @@ auto Parser::parse_statement() -> std::unique_ptr<ast::StmtNode>
     }
 }
 
-auto Parser::parse_let_statement() -> std::unique_ptr<ast::LetStmt>
+template <typename Builder>
+auto BasicParser<Builder>::parse_let_statement() -> Stmt
 {
     auto let_tok = m_curr_tok;
 
     if (!expect_peek_and_consume(TokenType::Identifier))
-        return nullptr;
+        return Builder::NO_STMT;
 
-    auto ident = ast::Identifier(std::move(m_curr_tok));
+    auto name_tok = m_curr_tok;
 
     if (!expect_peek_and_consume(TokenType::Equal))
-        return nullptr;
+        return Builder::NO_STMT;
     consume();
 
     auto value = parse_expression(PrecedenceLevel::Lowest);
@@ -120,10 +194,11 @@ auto Parser::parse_let_statement() -> std::unique_ptr<ast::LetStmt>
     if (peek_type_is(TokenType::Semicolon))
         consume();
 
-    return std::make_unique<ast::LetStmt>(let_tok, std::move(ident), std::move(value));
+    return m_build.let(let_tok, name_tok, value);
 }
 
-auto Parser::parse_return_statement() -> std::unique_ptr<ast::ReturnStmt>
+template <typename Builder>
+auto BasicParser<Builder>::parse_return_statement() -> Stmt
 {
     auto ret_tok = m_curr_tok;
     consume();
@@ -132,10 +207,11 @@ auto Parser::parse_return_statement() -> std::unique_ptr<ast::ReturnStmt>
     if (peek_type_is(TokenType::Semicolon))
         consume();
 
-    return std::make_unique<ast::ReturnStmt>(ret_tok, std::move(ret_value));
+    return m_build.ret(ret_tok, ret_value);
 }
 
-auto Parser::parse_expression_statement() -> std::unique_ptr<ast::ExpressionStmt>
+template <typename Builder>
+auto BasicParser<Builder>::parse_expression_statement() -> Stmt
 {
     auto expr_tok   = m_curr_tok;  // Not moving, parse_expr() needs m_curr_tok
     auto expression = parse_expression(PrecedenceLevel::Lowest);
@@ -143,228 +219,237 @@ auto Parser::parse_expression_statement() -> std::unique_ptr<ast::ExpressionStmt
     if (peek_type_is(TokenType::Semicolon))
         consume();
 
-    return std::make_unique<ast::ExpressionStmt>(std::move(expr_tok), std::move(expression));
+    return m_build.expr_stmt(expr_tok, expression);
 }
 
-auto Parser::parse_block_statement() -> std::unique_ptr<ast::BlockStmt>
+template <typename Builder>
+auto BasicParser<Builder>::parse_block_statement() -> Block
 {
-    auto blk_tok = m_curr_tok;
-    auto blk     = std::make_unique<ast::BlockStmt>(blk_tok);
+    auto stmts = m_build.begin_block(m_curr_tok);
     consume();
     while (!curr_type_is(TokenType::RightBrace))
     {
         if (curr_type_is(TokenType::EOS))
         {
             m_errors.emplace_back("Block statement missing closing '}'");
-            return nullptr;
+            return Builder::NO_BLOCK;
         }
         auto stmt = parse_statement();
-        if (stmt)
-            blk->push_stmt(std::move(stmt));
+        if (stmt != Builder::NO_STMT)
+            m_build.push_stmt(stmts, stmt);
         consume();
     }
-    return blk;
+    return m_build.end_block(stmts);
 }
 
-auto Parser::parse_expression(PrecedenceLevel precedence) -> ast::ExprNodePtr
+template <typename Builder>
+auto BasicParser<Builder>::parse_expression(PrecedenceLevel precedence) -> Expr
 {
-    auto prefix_fn = m_prefix_parse_fns[m_curr_tok.m_type];
+    const auto prefix_fn = M_PREFIX_PARSE_FNS[index(m_curr_tok.m_type)];
     if (!prefix_fn)
         return parse_fn_error(m_curr_tok.m_type, ParseFnType::Prefix);
 
-    auto left_expr = prefix_fn();
+    auto left_expr = (this->*prefix_fn)();
     while (!peek_type_is(TokenType::Semicolon) && precedence < peek_precedence())
     {
-        auto infix_fn = m_infix_parse_fns[m_peek_tok.m_type];
+        const auto infix_fn = M_INFIX_PARSE_FNS[index(m_peek_tok.m_type)];
         if (!infix_fn)
         {
             parse_fn_error(m_curr_tok.m_type, ParseFnType::Infix);
             return left_expr;
         }
         consume();
-        left_expr = infix_fn(std::move(left_expr));
+        left_expr = (this->*infix_fn)(left_expr);
     }
 
     return left_expr;
 }
 
-auto Parser::parse_prefix_expression() -> ast::ExprNodePtr
+template <typename Builder>
+auto BasicParser<Builder>::parse_prefix_expression() -> Expr
 {
     auto prefix_tok = m_curr_tok;
     consume();
     auto right_expr = parse_expression(PrecedenceLevel::Prefix);
-    return std::make_unique<ast::PrefixExpression>(prefix_tok, std::move(right_expr));
+    return m_build.prefix(prefix_tok, right_expr);
 }
 
-auto Parser::parse_infix_expression(ast::ExprNodePtr left_expr) -> ast::ExprNodePtr
+template <typename Builder>
+auto BasicParser<Builder>::parse_infix_expression(Expr left_expr) -> Expr
 {
     auto infix_tok  = m_curr_tok;
     auto precedence = curr_precedence();
     consume();
     auto right_expr = parse_expression(precedence);
-    return std::make_unique<ast::InfixExpression>(infix_tok,
-                                                  std::move(left_expr), std::move(right_expr));
+    return m_build.infix(infix_tok, left_expr, right_expr);
 }
 
-auto Parser::parse_identifier() -> ast::ExprNodePtr
+template <typename Builder>
+auto BasicParser<Builder>::parse_identifier() -> Expr
 {
-    return std::make_unique<ast::Identifier>(std::move(m_curr_tok));
+    return m_build.identifier(m_curr_tok);
 }
 
-auto Parser::parse_int_literal() -> ast::ExprNodePtr
+template <typename Builder>
+auto BasicParser<Builder>::parse_int_literal() -> Expr
 {
     std::string_view buff{m_curr_tok.m_literal.value()};
 
-    int int_val{};
+    std::int64_t int_val{};
     if (const auto [p, ec] =
           std::from_chars(buff.data(), buff.data() + buff.size(), int_val);
         ec == std::errc())
     {
-        return std::make_unique<ast::IntLiteral>(std::move(m_curr_tok), int_val);
+        return m_build.int_literal(m_curr_tok, int_val);
     }
 
     m_errors.emplace_back("Could not parse " + std::string{buff} + " as integer");
-    return nullptr;
+    return Builder::NO_EXPR;
 }
 
-auto Parser::parse_boolean() -> ast::ExprNodePtr
+template <typename Builder>
+auto BasicParser<Builder>::parse_boolean() -> Expr
 {
-    auto bool_tok = m_curr_tok;
     bool bool_val = m_curr_tok.m_type == TokenType::True;
-    return std::make_unique<ast::Boolean>(bool_tok, bool_val);
+    return m_build.boolean(m_curr_tok, bool_val);
 }
 
-auto Parser::parse_grouped_expression() -> ast::ExprNodePtr
+template <typename Builder>
+auto BasicParser<Builder>::parse_grouped_expression() -> Expr
 {
     consume();
     auto expression = parse_expression(PrecedenceLevel::Lowest);
 
     if (!expect_peek_and_consume(TokenType::RightParen))
-        return nullptr;
+        return Builder::NO_EXPR;
 
     return expression;
 }
 
-auto Parser::parse_if_expression() -> ast::ExprNodePtr
+template <typename Builder>
+auto BasicParser<Builder>::parse_if_expression() -> Expr
 {
     auto if_tok = m_curr_tok;
 
     if (!expect_peek_and_consume(TokenType::LeftParen))
-        return nullptr;
+        return Builder::NO_EXPR;
     consume();
 
     auto condition = parse_expression(PrecedenceLevel::Lowest);
 
     if (!expect_peek_and_consume(TokenType::RightParen))
-        return nullptr;
+        return Builder::NO_EXPR;
     if (!expect_peek_and_consume(TokenType::LeftBrace))
-        return nullptr;
+        return Builder::NO_EXPR;
 
     auto consequence = parse_block_statement();
 
-    ast::OptIfAltBlk alternative;
+    std::optional<Block> alternative;
     if (peek_type_is(TokenType::Else))
     {
         consume();
         if (!expect_peek_and_consume(TokenType::LeftBrace))
-            return nullptr;
+            return Builder::NO_EXPR;
 
         alternative = parse_block_statement();
     }
 
-    return std::make_unique<ast::IfExpression>(if_tok, std::move(condition),
-                                               std::move(consequence), std::move(alternative));
+    return m_build.if_expr(if_tok, condition, consequence, alternative);
 }
 
-auto Parser::parse_function_literal() -> ast::ExprNodePtr
+template <typename Builder>
+auto BasicParser<Builder>::parse_function_literal() -> Expr
 {
     auto func_tok = m_curr_tok;
 
     if (!expect_peek_and_consume(TokenType::LeftParen))
-        return nullptr;
+        return Builder::NO_EXPR;
 
     auto params = parse_function_params();
 
     if (!expect_peek_and_consume(TokenType::LeftBrace))
-        return nullptr;
+        return Builder::NO_EXPR;
 
     auto body = parse_block_statement();
 
-    return std::make_unique<ast::FunctionLiteral>(func_tok, std::move(params), std::move(body));
+    return m_build.function(func_tok, params, body);
 }
 
-auto Parser::parse_function_params() -> ast::OptFnParams
+template <typename Builder>
+auto BasicParser<Builder>::parse_function_params() -> Params
 {
     if (peek_type_is(TokenType::RightParen))
     {
         consume();
-        return std::nullopt;
+        return Builder::no_params();
     }
     consume();
 
-    auto ident = ast::Identifier(std::move(m_curr_tok));
-
-    std::vector<ast::Identifier> params{std::move(ident)};
+    auto params = m_build.begin_params();
+    m_build.push_param(params, m_curr_tok);
     while (peek_type_is(TokenType::Comma))
     {
         consume();
         consume();
-        ident = ast::Identifier(std::move(m_curr_tok));
-        params.push_back(std::move(ident));
+        m_build.push_param(params, m_curr_tok);
     }
 
+    // The list still ends, so the Builder's stack of items stays balanced
+    auto parsed = m_build.end_params(params);
     if (!expect_peek_and_consume(TokenType::RightParen))
-        return nullptr;
+        return Builder::no_params();
 
-    return std::make_unique<std::vector<ast::Identifier>>(std::move(params));
+    return parsed;
 }
 
-auto Parser::parse_call_expression(ast::ExprNodePtr function) -> ast::ExprNodePtr
+template <typename Builder>
+auto BasicParser<Builder>::parse_call_expression(Expr function) -> Expr
 {
     auto call_tok  = m_curr_tok;
     auto arguments = parse_call_arguments();
-    return std::make_unique<ast::CallExpression>(call_tok,
-                                                 std::move(function), std::move(arguments));
+    return m_build.call(call_tok, function, arguments);
 }
 
-auto Parser::parse_call_arguments() -> ast::OptCallArgs
+template <typename Builder>
+auto BasicParser<Builder>::parse_call_arguments() -> Args
 {
     if (peek_type_is(TokenType::RightParen))
     {
         consume();
-        return std::nullopt;
+        return Builder::no_args();
     }
     consume();
 
-    auto args_expr = parse_expression(PrecedenceLevel::Lowest);
-
-    ast::ExprNodeVector args;
-    args.push_back(std::move(args_expr));
+    auto args = m_build.begin_args();
+    m_build.push_arg(args, parse_expression(PrecedenceLevel::Lowest));
     while (peek_type_is(TokenType::Comma))
     {
         consume();
         consume();
-        args_expr = parse_expression(PrecedenceLevel::Lowest);
-        args.push_back(std::move(args_expr));
+        m_build.push_arg(args, parse_expression(PrecedenceLevel::Lowest));
     }
 
+    auto parsed = m_build.end_args(args);
     if (!expect_peek_and_consume(TokenType::RightParen))
-        return nullptr;
+        return Builder::no_args();
 
-    return std::make_unique<ast::ExprNodeVector>(std::move(args));
+    return parsed;
 }
 
-bool Parser::curr_type_is(const TokenType& type) const
+template <typename Builder>
+bool BasicParser<Builder>::curr_type_is(const TokenType& type) const
 {
     return m_curr_tok.m_type == type;
 }
 
-bool Parser::peek_type_is(const TokenType& type) const
+template <typename Builder>
+bool BasicParser<Builder>::peek_type_is(const TokenType& type) const
 {
     return m_peek_tok.m_type == type;
 }
 
-bool Parser::expect_peek_and_consume(const TokenType& type)
+template <typename Builder>
+bool BasicParser<Builder>::expect_peek_and_consume(const TokenType& type)
 {
     if (peek_type_is(type))
     {
@@ -375,7 +460,8 @@ bool Parser::expect_peek_and_consume(const TokenType& type)
     return false;
 }
 
-void Parser::peek_error(const TokenType& type)
+template <typename Builder>
+void BasicParser<Builder>::peek_error(const TokenType& type)
 {
     m_errors.emplace_back("Expected next token to be "
                           + tok::type_to_string(type)
@@ -384,27 +470,20 @@ void Parser::peek_error(const TokenType& type)
                           + " instead");
 }
 
-void Parser::register_prefix(TokenType type, PrefixParseFn pre_parse_fn)
-{
-    m_prefix_parse_fns[type] = std::move(pre_parse_fn);
-}
-
-void Parser::register_infix(TokenType type, InfixParseFn in_parse_fn)
-{
-    m_infix_parse_fns[type] = std::move(in_parse_fn);
-}
-
-auto Parser::curr_precedence() const -> PrecedenceLevel
+template <typename Builder>
+auto BasicParser<Builder>::curr_precedence() const -> PrecedenceLevel
 {
     return precedence_lookup(m_curr_tok.m_type);
 }
 
-auto Parser::peek_precedence() const -> PrecedenceLevel
+template <typename Builder>
+auto BasicParser<Builder>::peek_precedence() const -> PrecedenceLevel
 {
     return precedence_lookup(m_peek_tok.m_type);
 }
 
-ast::ExprNodePtr Parser::parse_fn_error(TokenType tok_type, ParseFnType parse_type)
+template <typename Builder>
+auto BasicParser<Builder>::parse_fn_error(TokenType tok_type, ParseFnType parse_type) -> Expr
 {
     if (parse_type == ParseFnType::Infix)
         m_errors.emplace_back("No infix parse function found for token '"
@@ -412,7 +491,7 @@ ast::ExprNodePtr Parser::parse_fn_error(TokenType tok_type, ParseFnType parse_ty
     else
         m_errors.emplace_back("No prefix parse function found for token '"
                               + tok::type_to_string(tok_type) + "'");
-    return nullptr;
+    return Builder::NO_EXPR;
 }
 
 static constexpr auto precedence_lookup(TokenType type) -> PrecedenceLevel
@@ -440,4 +519,7 @@ static constexpr auto precedence_lookup(TokenType type) -> PrecedenceLevel
     }
 }
 
+template class BasicParser<TreeBuilder>;
+template class BasicParser<ast::FlatBuilder>;
+
 }  // namespace punky::par
@@ -0,0 +1,236 @@
+#include "punky/Resolver.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include <punky/ScopeNames.hpp>
+#include <punky/Symbol.hpp>
+#include <punky/ast.hpp>
+
+namespace punky::resolve
+{
+
+using punky::ast::AstType;
+
+// The tree as mark_tail() sees it
+struct TreeView
+{
+    using Expr = const ast::ExprNode*;
+
+    [[nodiscard]] static AstType kind(Expr expr) { return expr->ast_type(); }
+
+    [[nodiscard]] static auto consequence(Expr expr) -> const ast::BlockStmt* { return expr->if_expr()->consequence(); }
+    [[nodiscard]] static auto alternative(Expr expr) -> const ast::BlockStmt* { return expr->if_expr()->alternative(); }
+
+    [[nodiscard]] static auto last_expression(const ast::BlockStmt* block) -> std::optional<Expr>
+    {
+        if (!block || block->statements().empty()
+            || block->statements().back()->ast_type() != AstType::ExpressionStmt)
+            return std::nullopt;
+        return block->statements().back()->expr_stmt()->expression();
+    }
+};
+
+static void mark_tail_calls(TreeView::Expr expr)
+{
+    mark_tail(TreeView{}, expr, [](TreeView::Expr call) { call->call_expr()->set_tail(true); });
+}
+
+Resolver::Resolver() :
+  m_scopes(1)
+{}
+
+void Resolver::resolve(const ast::Program& prog)
+{
+    resolve_block(prog.statements());
+    resolve_deferred();
+}
+
+void Resolver::resolve_block(const ast::StmtNodeVector& stmts)
+{
+    for (const auto& stmt : stmts)
+        resolve_statement(*stmt);
+}
+
+void Resolver::resolve_statement(const ast::StmtNode& stmt)
+{
+    switch (stmt.ast_type())
+    {
+        case AstType::ExpressionStmt:
+            resolve_expression(*stmt.expr_stmt()->expression());
+            break;
+
+        case AstType::LetStmt:
+        {
+            // The right hand side still sees an outer binding of the same
+            // name. A function literal bound by the let cannot be called
+            // before the let binds it, so its body may count on the name.
+            const auto& rhs = *stmt.let_stmt()->rhs();
+            if (rhs.ast_type() == AstType::Function)
+                m_scopes.back().m_deferred.push_back(Deferred{rhs.fn_lit(), m_scopes.back().m_position + 1});
+            else
+                resolve_expression(rhs);
+
+            declare(stmt.let_stmt()->lhs());
+            break;
+        }
+
+        case AstType::ReturnStmt:
+            resolve_expression(*stmt.return_stmt()->ret_expr());
+
+            // Wherever it is, a return in a function ends its call
+            if (m_scopes.size() > 1)
+                mark_tail_calls(stmt.return_stmt()->ret_expr());
+            break;
+
+        case AstType::BlockStmt:
+            resolve_block(stmt.block_stmt()->statements());
+            break;
+
+        default:
+            break;
+    }
+}
+
+void Resolver::resolve_expression(const ast::ExprNode& expr)
+{
+    switch (expr.ast_type())
+    {
+        case AstType::Identifier:
+            lookup(*expr.identifier());
+            break;
+
+        case AstType::Prefix:
+            resolve_expression(*expr.prefix_expr()->right());
+            break;
+
+        case AstType::Infix:
+            resolve_expression(*expr.infix_expr()->left());
+            resolve_expression(*expr.infix_expr()->right());
+            break;
+
+        case AstType::If:
+        {
+            // Blocks do not open a scope, their lets bind in the enclosing function
+            const auto& if_expr = *expr.if_expr();
+            resolve_expression(*if_expr.condition());
+            resolve_block(if_expr.consequence()->statements());
+            if (const auto* alt = if_expr.alternative(); alt)
+                resolve_block(alt->statements());
+            break;
+        }
+
+        case AstType::Function:
+            m_scopes.back().m_deferred.push_back(Deferred{expr.fn_lit(), m_scopes.back().m_position});
+            break;
+
+        case AstType::Call:
+            resolve_expression(*expr.call_expr()->function());
+            if (const auto* args = expr.call_expr()->arguments(); args)
+            {
+                for (const auto& arg : *args)
+                    resolve_expression(*arg);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void Resolver::resolve_function(const Deferred& deferred)
+{
+    const auto& fn = *deferred.m_fn;
+
+    // Indexed, as resolving a function pushes onto m_scopes
+    const auto level = m_scopes.size();
+    m_scopes.emplace_back();
+    m_scopes[level].m_entry_position = deferred.m_position;
+
+    if (const auto* params = fn.params(); params)
+    {
+        for (const auto& param : *params)
+            param.bind(0, static_cast<int>(m_scopes[level].declare_param(param.symbol())), false);
+    }
+
+    const auto* body = fn.body()->block_stmt();
+    for (const auto& stmt : body->statements())
+    {
+        resolve_statement(*stmt);
+
+        const auto is_let = stmt->ast_type() == AstType::LetStmt;
+        m_scopes[level].end_statement(is_let ? std::optional{stmt->let_stmt()->lhs().symbol()} : std::nullopt);
+    }
+    if (const auto last = TreeView::last_expression(body); last)
+        mark_tail_calls(*last);
+
+    for (const auto& read : m_scopes[level].m_reads)
+        bind_read(read);
+
+    // Function literals directly in the body are exactly the ones whose
+    // Function Objects hold this call's Environment
+    fn.set_env_escapes(!m_scopes[level].m_deferred.empty());
+    resolve_deferred();
+
+    fn.set_num_locals(m_scopes[level].m_num_slots);
+    m_scopes.pop_back();
+}
+
+void Resolver::resolve_deferred()
+{
+    // Indexed, as resolving a function pushes onto m_scopes
+    const auto level = m_scopes.size() - 1;
+    for (std::size_t i = 0; i < m_scopes[level].m_deferred.size(); ++i)
+        resolve_function(m_scopes[level].m_deferred[i]);
+    m_scopes[level].m_deferred.clear();
+}
+
+void Resolver::declare(const ast::Identifier& ident)
+{
+    const auto global = m_scopes.size() == 1;
+    const auto slot   = global ? global_slot(ident.symbol()) : m_scopes.back().declare(ident.symbol()).first;
+    ident.bind(0, static_cast<int>(slot), global);
+}
+
+void Resolver::lookup(const ast::Identifier& ident)
+{
+    if (m_scopes.size() == 1)
+        ident.bind(0, static_cast<int>(global_slot(ident.symbol())), true);
+    else
+        m_scopes.back().m_reads.push_back(Read{&ident, m_scopes.back().m_position});
+}
+
+// Binds the read to each scope find_bindings() looks in, each binding the
+// fallback of the one before. The last resort is the global, which fails at
+// run time if it never was bound.
+void Resolver::bind_read(const Read& read)
+{
+    const auto  symbol  = read.m_ident->symbol();
+    const auto  current = static_cast<int>(m_scopes.size() - 1);
+    const auto* binding = static_cast<const ast::Identifier*>(nullptr);
+
+    const auto next = [&]() {
+        if (!binding)
+            return binding = read.m_ident;
+
+        binding->set_fallback(&m_fallbacks.emplace_back(*read.m_ident));
+        return binding = binding->fallback();
+    };
+
+    const auto found = [&](std::size_t level, std::uint32_t slot) {
+        next()->bind(current - static_cast<int>(level), static_cast<int>(slot), false);
+    };
+
+    if (!find_bindings(m_scopes, symbol, read.m_position, found))
+        next()->bind(current, static_cast<int>(global_slot(symbol)), true);
+    binding->set_fallback(nullptr);
+}
+
+// Unknown names become globals that may be bound later
+auto Resolver::global_slot(sym::SymbolId symbol) -> std::uint32_t
+{
+    return m_scopes.front().declare(symbol).first;
+}
+
+}  // namespace punky::resolve
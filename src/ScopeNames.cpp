@@ -0,0 +1,34 @@
+#include "punky/ScopeNames.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include <punky/Symbol.hpp>
+
+namespace punky::resolve
+{
+
+auto ScopeNames::declare(sym::SymbolId symbol) -> std::pair<std::uint32_t, bool>
+{
+    const auto [res, inserted] = m_slots.try_emplace(symbol, m_num_slots);
+    if (inserted)
+        ++m_num_slots;
+    return {res->second, inserted};
+}
+
+auto ScopeNames::declare_param(sym::SymbolId symbol) -> std::uint32_t
+{
+    m_slots[symbol]      = m_num_slots;
+    m_bound_from[symbol] = 0;
+    return m_num_slots++;
+}
+
+void ScopeNames::end_statement(std::optional<sym::SymbolId> let)
+{
+    ++m_position;
+    if (let.has_value())
+        m_bound_from.try_emplace(let.value(), m_position);
+}
+
+}  // namespace punky::resolve
@@ -0,0 +1,73 @@
+#include "punky/Session.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <variant>
+
+#include <punky/Environment.hpp>
+#include <punky/Evaluator.hpp>
+#include <punky/FlatAst.hpp>
+#include <punky/Lexer.hpp>
+#include <punky/Object.hpp>
+#include <punky/Parser.hpp>
+#include <punky/ast.hpp>
+
+namespace punky::repl
+{
+
+Session::Session(Engine engine, std::size_t max_depth) :
+  m_engine{engine},
+  m_max_depth{max_depth},
+  m_folder{m_arena},
+  m_env{env::Environment::make()},
+  m_env_root{m_env},
+  m_thunks{max_depth},
+  m_vm{max_depth}
+{}
+
+auto Session::run(std::string_view source) -> std::optional<obj::Object>
+{
+    if (m_engine == Engine::VM)
+        return run_compiled(source);
+
+    auto lex = lex::Lexer{source};
+    auto par = par::Parser{lex, m_arena};
+
+    auto parsed = par.parse_program();
+    if (std::holds_alternative<bool>(parsed))
+        return std::nullopt;
+
+    auto& chunk = *std::get<ast::Program*>(parsed);
+    m_folder.fold(chunk);
+
+    m_resolver.resolve(chunk);
+    if (m_engine == Engine::Thunks)
+        return m_thunks.compile(chunk)(*m_env);
+
+    return eval::Evaluator{chunk, m_max_depth}.interpret(*m_env);
+}
+
+// The Compiler only walks the FlatAst, so the pointer tree is never built
+auto Session::run_compiled(std::string_view source) -> std::optional<obj::Object>
+{
+    auto lex  = lex::Lexer{source};
+    auto flat = ast::FlatAst{};
+    auto par  = par::FlatParser{lex, flat};
+    if (std::holds_alternative<bool>(par.parse_program()))
+        return std::nullopt;
+
+    return m_vm.run(m_compiler.compile(std::move(flat)));
+}
+
+auto Session::run_line(std::string_view line) -> std::optional<obj::Object>
+{
+    // Nothing the Compiler keeps points into the source
+    if (m_engine == Engine::VM)
+        return run_compiled(line);
+
+    return run(m_arena.copy_source(line));
+}
+
+}  // namespace punky::repl
@@ -0,0 +1,123 @@
+#include "punky/SourceFile.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace punky::io
+{
+
+SourceFile::SourceFile(SourceFile&& other) noexcept :
+  m_mapping{std::exchange(other.m_mapping, nullptr)},
+  m_mapped_size{std::exchange(other.m_mapped_size, 0)},
+  m_buffer{std::move(other.m_buffer)},
+  m_text{m_mapping ? other.m_text : std::string_view{m_buffer}}
+{
+    other.m_text = {};
+}
+
+SourceFile& SourceFile::operator=(SourceFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        unmap();
+        m_mapping     = std::exchange(other.m_mapping, nullptr);
+        m_mapped_size = std::exchange(other.m_mapped_size, 0);
+        m_buffer      = std::move(other.m_buffer);
+        m_text        = m_mapping ? other.m_text : std::string_view{m_buffer};
+        other.m_text  = {};
+    }
+    return *this;
+}
+
+SourceFile::~SourceFile()
+{
+    unmap();
+}
+
+auto SourceFile::open(const std::string& path) -> std::optional<SourceFile>
+{
+    auto file = SourceFile{};
+
+    if (path == "-")
+    {
+        file.m_buffer.assign(std::istreambuf_iterator<char>{std::cin},
+                             std::istreambuf_iterator<char>{});
+        file.m_text = file.m_buffer;
+        return file;
+    }
+
+    const auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return std::nullopt;
+
+    struct stat info
+    {};
+    if (::fstat(fd, &info) < 0)
+    {
+        const auto err = errno;
+        ::close(fd);
+        errno = err;
+        return std::nullopt;
+    }
+
+    if (S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        const auto size = static_cast<std::size_t>(info.st_size);
+        auto*      data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            // The Lexer reads front to back exactly once
+            ::madvise(data, size, MADV_SEQUENTIAL);
+            ::close(fd);
+
+            file.m_mapping     = data;
+            file.m_mapped_size = size;
+            file.m_text        = std::string_view{static_cast<const char*>(data), size};
+            return file;
+        }
+    }
+
+    // Not mappable: a pipe, a device or an empty file
+    char buff[1 << 16];
+    for (;;)
+    {
+        const auto count = ::read(fd, buff, sizeof(buff));
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0)
+        {
+            const auto err = errno;
+            ::close(fd);
+            errno = err;
+            return std::nullopt;
+        }
+        if (count == 0)
+            break;
+        file.m_buffer.append(buff, static_cast<std::size_t>(count));
+    }
+    ::close(fd);
+
+    file.m_text = file.m_buffer;
+    return file;
+}
+
+void SourceFile::unmap()
+{
+    if (m_mapping)
+        ::munmap(m_mapping, m_mapped_size);
+    m_mapping     = nullptr;
+    m_mapped_size = 0;
+}
+
+}  // namespace punky::io
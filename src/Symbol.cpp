@@ -0,0 +1,26 @@
+#include "punky/Symbol.hpp"
+
+#include <string>
+#include <string_view>
+
+namespace punky::sym
+{
+
+auto SymbolTable::intern(std::string_view name) -> SymbolId
+{
+    if (const auto res = m_ids.find(name); res != m_ids.cend())
+        return res->second;
+
+    const auto  id     = static_cast<SymbolId>(m_names.size());
+    const auto& stored = m_names.emplace_back(name);
+    m_ids.emplace(stored, id);
+    return id;
+}
+
+auto symbols() -> SymbolTable&
+{
+    static SymbolTable table;
+    return table;
+}
+
+}  // namespace punky::sym
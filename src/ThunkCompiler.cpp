@@ -0,0 +1,437 @@
+#include "punky/ThunkCompiler.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <punky/CallStack.hpp>
+#include <punky/Environment.hpp>
+#include <punky/FObject.hpp>
+#include <punky/Heap.hpp>
+#include <punky/Object.hpp>
+#include <punky/Token.hpp>
+#include <punky/ast.hpp>
+#include <punky/operators.hpp>
+
+namespace punky::thunk
+{
+
+using punky::ast::AstType;
+using punky::obj::extend_fn_env;
+using punky::obj::FunctionObject;
+using punky::obj::ObjectType;
+using punky::ops::is_abrupt;
+using punky::ops::is_error;
+using punky::ops::is_truthy;
+using punky::tok::TokenType;
+
+using Thunks = std::vector<Thunk>;
+
+// The right operand of an infix expression: an int literal is inlined into
+// the Thunk of the expression rather than called.
+struct Operand
+{
+    Thunk                       m_thunk;
+    std::optional<std::int64_t> m_int;
+};
+
+// The int fast path of an operator, one of the ops::int_*() functions
+template <Object (*Fn)(std::int64_t, std::int64_t)>
+struct IntOp
+{
+    Object operator()(std::int64_t left, std::int64_t right) const { return Fn(left, right); }
+};
+
+// For an operator ints lack
+struct NoIntOp
+{
+};
+
+// Int operands take Op inline, anything else goes through ops::infix()
+template <typename Op>
+static Object infix(TokenType op, const Object& left, const Object& right)
+{
+    if constexpr (!std::is_same_v<Op, NoIntOp>)
+    {
+        if (left.type() == ObjectType::Int && right.type() == ObjectType::Int)
+            return Op{}(left.as_int(), right.as_int());
+    }
+    return ops::infix(op, left, right);
+}
+
+template <typename Op>
+static auto infix_thunk(TokenType op, Thunk left, Operand right) -> Thunk
+{
+    if (right.m_int.has_value())
+    {
+        return [op, left = std::move(left), right = Object{right.m_int.value()}](env::Environment& env) {
+            auto left_val = left(env);
+            return is_abrupt(left_val) ? left_val : infix<Op>(op, left_val, right);
+        };
+    }
+
+    return [op, left = std::move(left), right = std::move(right.m_thunk)](env::Environment& env) {
+        auto left_val = left(env);
+        if (is_abrupt(left_val))
+            return left_val;
+
+        const auto left_root = gc::Root{left_val};
+
+        auto right_val = right(env);
+        if (is_abrupt(right_val))
+            return right_val;
+
+        return infix<Op>(op, left_val, right_val);
+    };
+}
+
+ThunkCompiler::ThunkCompiler(std::size_t max_depth) :
+  m_calls{max_depth}
+{
+}
+
+auto ThunkCompiler::compile(const ast::Program& prog) -> Thunk
+{
+    auto stmts = Thunks{};
+    for (const auto& stmt : prog.statements())
+        stmts.push_back(compile_node(*stmt));
+
+    return [this, stmts = std::move(stmts)](env::Environment& env) {
+        m_globals = &env;
+
+        Object result{};
+        for (const auto& stmt : stmts)
+        {
+            result = stmt(env);
+
+            if (result.returning())
+            {
+                result.set_returning(false);
+                return result;
+            }
+
+            if (is_error(result))
+                return result;
+        }
+        return result;
+    };
+}
+
+auto ThunkCompiler::compile_node(const ast::AstNode& node) -> Thunk
+{
+    switch (node.ast_type())
+    {
+        case AstType::ExpressionStmt:
+            return compile_node(*node.expr_stmt()->expression());
+
+        case AstType::BlockStmt:
+            return compile_block(*node.block_stmt());
+
+        case AstType::ReturnStmt:
+            return [value = compile_node(*node.return_stmt()->ret_expr())](env::Environment& env) {
+                auto val = value(env);
+                if (!is_error(val))
+                    val.set_returning(true);
+                return val;
+            };
+
+        case AstType::LetStmt:
+            return [slot  = node.let_stmt()->lhs().slot(),
+                    value = compile_node(*node.let_stmt()->rhs())](env::Environment& env) {
+                auto val = value(env);
+                if (is_abrupt(val))
+                    return val;
+
+                env.set(slot, val);
+                return Object{ObjectType::EmptyOut};
+            };
+
+        case AstType::Int:
+            return [value = Object{node.int_lit()->value()}](env::Environment& /*env*/) { return value; };
+
+        case AstType::Bool:
+            return [value = Object{node.boolean()->value()}](env::Environment& /*env*/) { return value; };
+
+        case AstType::Prefix:
+            return [op    = node.expr()->type(),
+                    right = compile_node(*node.prefix_expr()->right())](env::Environment& env) {
+                auto right_val = right(env);
+                return is_abrupt(right_val) ? right_val : ops::prefix(op, right_val);
+            };
+
+        case AstType::Infix:
+            return compile_infix(*node.infix_expr());
+
+        case AstType::If:
+            return compile_if(*node.if_expr());
+
+        case AstType::Identifier:
+        {
+            const auto& ident = *node.identifier();
+            if (ident.is_global())
+                return compile_global(ident);
+
+            if (ident.fallback())
+                return compile_fallback(ident);
+
+            return [depth = ident.depth(), slot = ident.slot(), name = ident.name()](env::Environment& env) {
+                if (auto val = env.get(depth, slot); val.has_value())
+                    return val.value();
+                return ops::unknown_ident_error(name);
+            };
+        }
+
+        case AstType::Function:
+        {
+            const auto* fn_lit = node.fn_lit();
+            body(fn_lit);
+            return [fn_lit](env::Environment& env) { return obj::make_function(fn_lit, &env); };
+        }
+
+        case AstType::Call:
+            return compile_call(*node.call_expr());
+
+        default:
+            return [](env::Environment& /*env*/) { return Object{ObjectType::Null}; };
+    }
+}
+
+auto ThunkCompiler::compile_block(const ast::BlockStmt& block) -> Thunk
+{
+    if (block.statements().size() == 1)
+        return compile_node(*block.statements().front());
+
+    auto stmts = Thunks{};
+    for (const auto& stmt : block.statements())
+        stmts.push_back(compile_node(*stmt));
+
+    return [stmts = std::move(stmts)](env::Environment& env) {
+        Object result{};
+        for (const auto& stmt : stmts)
+        {
+            result = stmt(env);
+
+            if (is_abrupt(result))
+                return result;
+        }
+        return result;
+    };
+}
+
+// Each read site caches the value it last read, for as long as the globals
+// keep the version they had then.
+auto ThunkCompiler::compile_global(const ast::Identifier& ident) -> Thunk
+{
+    return [this, slot = ident.slot(), name = ident.name(), version = std::uint64_t{},
+            value = Object{}](env::Environment& /*env*/) mutable {
+        if (m_globals->version() == version)
+            return value;
+        if (auto val = m_globals->get(0, slot); val.has_value())
+        {
+            version = m_globals->version();
+            value   = val.value();
+            return value;
+        }
+        return ops::unknown_ident_error(name);
+    };
+}
+
+// A local that may not be bound yet reads its fallbacks in turn, the last
+// of which may be a global
+auto ThunkCompiler::compile_fallback(const ast::Identifier& ident) -> Thunk
+{
+    return [this, &ident](env::Environment& env) {
+        for (const auto* binding = &ident; binding; binding = binding->fallback())
+        {
+            const auto val = binding->is_global() ? m_globals->get(0, binding->slot())
+                                                  : env.get(binding->depth(), binding->slot());
+            if (val.has_value())
+                return val.value();
+        }
+        return ops::unknown_ident_error(ident.name());
+    };
+}
+
+auto ThunkCompiler::compile_infix(const ast::InfixExpression& infix) -> Thunk
+{
+    const auto  op         = infix.type();
+    auto        left       = compile_node(*infix.left());
+    const auto& right_node = *infix.right();
+
+    auto right = right_node.ast_type() == AstType::Int
+                   ? Operand{{}, right_node.int_lit()->value()}
+                   : Operand{compile_node(right_node), std::nullopt};
+
+    switch (op)
+    {
+        case TokenType::Plus:
+            return infix_thunk<IntOp<ops::int_add>>(op, std::move(left), std::move(right));
+        case TokenType::Minus:
+            return infix_thunk<IntOp<ops::int_sub>>(op, std::move(left), std::move(right));
+        case TokenType::Asterisk:
+            return infix_thunk<IntOp<ops::int_mul>>(op, std::move(left), std::move(right));
+        case TokenType::Slash:
+            return infix_thunk<IntOp<ops::int_div>>(op, std::move(left), std::move(right));
+        case TokenType::Less:
+            return infix_thunk<IntOp<ops::int_less>>(op, std::move(left), std::move(right));
+        case TokenType::Greater:
+            return infix_thunk<IntOp<ops::int_greater>>(op, std::move(left), std::move(right));
+        case TokenType::EqualEqual:
+            return infix_thunk<IntOp<ops::int_equal>>(op, std::move(left), std::move(right));
+        case TokenType::BangEqual:
+            return infix_thunk<IntOp<ops::int_not_equal>>(op, std::move(left), std::move(right));
+        default:
+            return infix_thunk<NoIntOp>(op, std::move(left), std::move(right));
+    }
+}
+
+auto ThunkCompiler::compile_if(const ast::IfExpression& if_expr) -> Thunk
+{
+    auto condition   = compile_node(*if_expr.condition());
+    auto consequence = compile_block(*if_expr.consequence());
+
+    if (!if_expr.alternative())
+    {
+        return [condition = std::move(condition),
+                consequence = std::move(consequence)](env::Environment& env) {
+            auto cond = condition(env);
+            if (is_abrupt(cond))
+                return cond;
+
+            return is_truthy(cond) ? consequence(env) : Object{ObjectType::Null};
+        };
+    }
+
+    return [condition = std::move(condition), consequence = std::move(consequence),
+            alternative = compile_block(*if_expr.alternative())](env::Environment& env) {
+        auto cond = condition(env);
+        if (is_abrupt(cond))
+            return cond;
+
+        return is_truthy(cond) ? consequence(env) : alternative(env);
+    };
+}
+
+auto ThunkCompiler::compile_call(const ast::CallExpression& call) -> Thunk
+{
+    auto args = Thunks{};
+    if (const auto* arguments = call.arguments(); arguments)
+    {
+        for (const auto& arg : *arguments)
+            args.push_back(compile_node(*arg));
+    }
+
+    return [this, function = compile_node(*call.function()), args = std::move(args),
+            tail = call.is_tail(), cache = BodyCache{}](env::Environment& env) mutable {
+        auto fn = function(env);
+        if (is_abrupt(fn))
+            return fn;
+
+        const auto base = m_args.size();
+        m_args.push_back(fn);
+        for (const auto& arg : args)
+        {
+            auto value = arg(env);
+            if (is_abrupt(value))
+            {
+                // A tail call made by the argument leaves its callee and
+                // arguments above this call's, which it must not outlive
+                if (m_tail_body)
+                {
+                    m_args.erase(m_args.begin() + static_cast<std::ptrdiff_t>(base),
+                                 m_args.begin() + static_cast<std::ptrdiff_t>(m_tail_base));
+                    m_tail_base = base;
+                }
+                else
+                    m_args.resize(base);
+                return value;
+            }
+            m_args.push_back(value);
+        }
+
+        const auto* fn_body = body(fn, cache);
+        if (tail && fn_body)
+        {
+            m_tail_body = fn_body;
+            m_tail_base = base;
+            return ops::pending_tail_call();
+        }
+
+        return apply(base, fn_body);
+    };
+}
+
+auto ThunkCompiler::body(const ast::FunctionLiteral* fn_lit) -> const Thunk&
+{
+    if (const auto res = m_bodies.find(fn_lit); res != m_bodies.cend())
+        return res->second;
+
+    auto compiled = compile_node(*fn_lit->body());
+    return m_bodies.emplace(fn_lit, std::move(compiled)).first->second;
+}
+
+auto ThunkCompiler::body(const Object& fn, BodyCache& cache) -> const Thunk*
+{
+    if (fn.type() != ObjectType::Function)
+        return nullptr;
+
+    const auto* fn_lit = fn.as<FunctionObject>().fn();
+    if (fn_lit != cache.m_fn_lit)
+        cache = BodyCache{fn_lit, &body(fn_lit)};
+    return cache.m_body;
+}
+
+Object ThunkCompiler::apply(std::size_t base, const Thunk* body)
+{
+    // Each tail call made by the body runs in this loop rather than in a
+    // call of its own, as in the Evaluator.
+    for (;;)
+    {
+        if (!body)
+        {
+            auto error = ops::not_fn_error(m_args[base]);
+            m_args.resize(base);
+            return error;
+        }
+
+        const auto& fn_obj     = m_args[base].as<FunctionObject>();
+        const auto* params     = fn_obj.fn()->params();
+        const auto  num_params = params ? params->size() : 0;
+        const auto  argc       = m_args.size() - base - 1;
+        if (argc != num_params)
+        {
+            m_args.resize(base);
+            return ops::wrong_args_error(num_params, argc);
+        }
+
+        auto* fn_env = extend_fn_env(fn_obj, m_args.data() + base + 1);
+        m_args.resize(base);
+        if (!m_calls.push(fn_env))
+        {
+            env::Environment::release(fn_env);
+            return ops::stack_overflow_error(m_calls.max_depth());
+        }
+
+        gc::heap().safepoint();
+
+        auto value = m_calls.run([body, fn_env]() { return (*body)(*fn_env); });
+
+        m_calls.pop();
+        env::Environment::release(fn_env);
+
+        if (!m_tail_body)
+        {
+            value.set_returning(false);
+            return value;
+        }
+
+        body = std::exchange(m_tail_body, nullptr);
+        base = m_tail_base;
+    }
+}
+
+}  // namespace punky::thunk
@@ -1,14 +1,13 @@
 #include "punky/Token.hpp"
 
 #include <string>
-#include <unordered_map>
 
 namespace punky::tok
 {
 
-auto make_token(TokenType type, TokenLiteral literal) -> Token
+auto make_token(TokenType type, TokenLiteral literal, sym::SymbolId symbol) -> Token
 {
-    return Token{type, std::move(literal)};
+    return Token{type, literal, symbol};
 }
 
 std::string type_to_string(const TokenType& type)
@@ -93,7 +92,7 @@ std::string type_to_string(const TokenType& type)
     std::string tok_str{"{"};
     tok_str.append(" type: " + tok::type_to_string(tok.m_type) + ",");
     if (tok.m_literal.has_value())
-        tok_str.append(" literal: " + tok.m_literal.value() + " ");
+        tok_str.append(" literal: " + std::string{tok.m_literal.value()} + " ");
     tok_str.append("}");
     return tok_str;
 }
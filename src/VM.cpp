@@ -0,0 +1,445 @@
+#include "punky/VM.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <punky/CObject.hpp>
+#include <punky/Code.hpp>
+#include <punky/Compiler.hpp>
+#include <punky/Heap.hpp>
+#include <punky/Object.hpp>
+#include <punky/Symbol.hpp>
+#include <punky/Token.hpp>
+#include <punky/operators.hpp>
+
+namespace punky::vm
+{
+
+using punky::code::OpCode;
+using punky::code::OPERAND_WIDTH;
+using punky::code::read_operand;
+using punky::obj::CellObject;
+using punky::obj::ClosureObject;
+using punky::obj::ObjectType;
+using punky::tok::TokenType;
+
+// Labels as values are a GCC and Clang extension
+#if defined(PUNKY_THREADED_DISPATCH) && defined(__GNUC__)
+#    define PUNKY_VM_THREADED
+#endif
+
+static constexpr auto infix_token(OpCode op) -> TokenType;
+
+auto opcode_pairs() -> PairCounts&
+{
+    static PairCounts counts{};
+    return counts;
+}
+
+#ifdef PUNKY_VM_PROFILE
+static void count_pair(std::size_t& prev_op, std::uint8_t op)
+{
+    if (prev_op < code::NUM_OPCODES)
+        ++opcode_pairs()[prev_op][op];
+    prev_op = op;
+}
+#endif
+
+VM::VM(std::size_t max_depth) :
+  m_max_depth{max_depth}
+{
+    m_stack.reserve(STACK_RESERVE);
+    m_frames.reserve(FRAMES_RESERVE);
+    gc::heap().add_roots(*this);
+}
+
+VM::~VM()
+{
+    gc::heap().remove_roots(*this);
+}
+
+auto VM::run(const compile::Bytecode& code) -> Object
+{
+    m_constants    = code.m_constants;
+    m_global_names = code.m_global_names;
+    m_globals.resize(m_global_names->size());
+
+    m_frames.push_back(Frame{code.m_instructions.data(), code.m_instructions.data(), nullptr, 0});
+    return execute();
+}
+
+auto VM::execute() -> Object
+{
+    auto* frame = &m_frames.back();
+    auto* ip    = frame->m_ip;
+
+#ifdef PUNKY_VM_PROFILE
+    auto prev_op = code::NUM_OPCODES;
+#    define VM_PROFILE() count_pair(prev_op, *ip)
+#else
+#    define VM_PROFILE() static_cast<void>(0)
+#endif
+
+#ifdef PUNKY_VM_THREADED
+    // In OpCode order
+    static const void* const DISPATCH_TABLE[] = {
+      &&op_Constant, &&op_Pop,
+      &&op_Null, &&op_True, &&op_False, &&op_Empty,
+      &&op_Add, &&op_Sub, &&op_Mul, &&op_Div,
+      &&op_Equal, &&op_NotEqual, &&op_Greater, &&op_Less,
+      &&op_Minus, &&op_Bang,
+      &&op_Jump, &&op_JumpNotTruthy, &&op_JumpIfBound,
+      &&op_GetGlobal, &&op_SetGlobal, &&op_GetLocal, &&op_SetLocal,
+      &&op_MakeCell, &&op_GetCell, &&op_SetCell, &&op_GetFree, &&op_GetFreeCell,
+      &&op_Closure,
+      &&op_Call, &&op_TailCall, &&op_ReturnValue,
+      &&op_AddLocalConst, &&op_SubLocalConst,
+      &&op_JumpIfNotLess, &&op_JumpIfNotGreater, &&op_JumpIfNotEqual,
+    };
+    static_assert(std::size(DISPATCH_TABLE) == static_cast<std::size_t>(OpCode::JumpIfNotEqual) + 1);
+
+    // Each handler jumps straight to the next one, so every opcode gets an
+    // indirect branch of its own for the predictor to learn.
+#    define VM_OP(name) op_##name:
+#    define VM_NEXT     goto*(VM_PROFILE(), DISPATCH_TABLE[*ip++])
+
+    VM_NEXT;
+#else
+#    define VM_OP(name) case OpCode::name:
+#    define VM_NEXT     continue
+
+    while (true)
+    {
+        switch (static_cast<OpCode>((VM_PROFILE(), *ip++)))
+        {
+#endif
+            VM_OP(Constant)
+                m_stack.push_back((*m_constants)[read_operand(ip)]);
+                ip += OPERAND_WIDTH;
+                VM_NEXT;
+
+            VM_OP(Pop)
+                m_stack.pop_back();
+                VM_NEXT;
+
+            // clang-format off
+            VM_OP(Null)  m_stack.emplace_back(ObjectType::Null); VM_NEXT;
+            VM_OP(Empty) m_stack.emplace_back(ObjectType::EmptyOut); VM_NEXT;
+            VM_OP(True)  m_stack.emplace_back(true); VM_NEXT;
+            VM_OP(False) m_stack.emplace_back(false); VM_NEXT;
+            // clang-format on
+
+            VM_OP(Add)
+            VM_OP(Sub)
+            VM_OP(Mul)
+            VM_OP(Div)
+            VM_OP(Equal)
+            VM_OP(NotEqual)
+            VM_OP(Greater)
+            VM_OP(Less)
+            {
+                const auto op    = static_cast<OpCode>(ip[-1]);
+                const auto right = pop();
+                auto&      left  = m_stack.back();
+
+                left = ops::infix(infix_token(op), left, right);
+                if (ops::is_error(left))
+                    return fail(left);
+                VM_NEXT;
+            }
+
+            VM_OP(Minus)
+            VM_OP(Bang)
+            {
+                const auto op    = static_cast<OpCode>(ip[-1]);
+                auto&      right = m_stack.back();
+
+                right = ops::prefix(op == OpCode::Minus ? TokenType::Minus : TokenType::Bang, right);
+                if (ops::is_error(right))
+                    return fail(right);
+                VM_NEXT;
+            }
+
+            VM_OP(AddLocalConst)
+            VM_OP(SubLocalConst)
+            {
+                const auto  op    = static_cast<OpCode>(ip[-1]);
+                const auto& left  = m_stack[frame->m_base + read_operand(ip)];
+                const auto& right = (*m_constants)[read_operand(ip + OPERAND_WIDTH)];
+                ip += 2 * OPERAND_WIDTH;
+
+                auto result = ops::infix(infix_token(op), left, right);
+                if (ops::is_error(result))
+                    return fail(result);
+
+                m_stack.push_back(result);
+                VM_NEXT;
+            }
+
+            VM_OP(JumpIfNotLess)
+            VM_OP(JumpIfNotGreater)
+            VM_OP(JumpIfNotEqual)
+            {
+                const auto op    = static_cast<OpCode>(ip[-1]);
+                const auto right = pop();
+                const auto left  = pop();
+
+                const auto cond = ops::infix(infix_token(op), left, right);
+                if (ops::is_error(cond))
+                    return fail(cond);
+
+                if (!ops::is_truthy(cond))
+                    ip = frame->m_code + read_operand(ip);
+                else
+                    ip += OPERAND_WIDTH;
+                VM_NEXT;
+            }
+
+            VM_OP(Jump)
+                ip = frame->m_code + read_operand(ip);
+                VM_NEXT;
+
+            VM_OP(JumpNotTruthy)
+                if (!ops::is_truthy(pop()))
+                    ip = frame->m_code + read_operand(ip);
+                else
+                    ip += OPERAND_WIDTH;
+                VM_NEXT;
+
+            // Reading a name that may not be bound yet: an unbound value
+            // gives way to the next place the name may be found
+            VM_OP(JumpIfBound)
+                if (m_stack.back().type() != ObjectType::Unbound)
+                    ip = frame->m_code + read_operand(ip);
+                else
+                {
+                    m_stack.pop_back();
+                    ip += OPERAND_WIDTH;
+                }
+                VM_NEXT;
+
+            VM_OP(GetGlobal)
+            {
+                const auto slot = read_operand(ip);
+                ip += OPERAND_WIDTH;
+
+                const auto& global = m_globals[slot];
+                if (!global.has_value())
+                    return fail(ops::unknown_ident_error(sym::symbols().name((*m_global_names)[slot])));
+
+                m_stack.push_back(global.value());
+                VM_NEXT;
+            }
+
+            VM_OP(SetGlobal)
+                m_globals[read_operand(ip)] = pop();
+                ip += OPERAND_WIDTH;
+                VM_NEXT;
+
+            VM_OP(GetLocal)
+                m_stack.push_back(m_stack[frame->m_base + read_operand(ip)]);
+                ip += OPERAND_WIDTH;
+                VM_NEXT;
+
+            VM_OP(SetLocal)
+                m_stack[frame->m_base + read_operand(ip)] = pop();
+                ip += OPERAND_WIDTH;
+                VM_NEXT;
+
+            VM_OP(MakeCell)
+            {
+                auto& local = m_stack[frame->m_base + read_operand(ip)];
+                local       = obj::make_cell(local);
+                ip += OPERAND_WIDTH;
+                VM_NEXT;
+            }
+
+            VM_OP(GetCell)
+                m_stack.push_back(m_stack[frame->m_base + read_operand(ip)].as<CellObject>().value());
+                ip += OPERAND_WIDTH;
+                VM_NEXT;
+
+            VM_OP(SetCell)
+            {
+                auto* cell = m_stack[frame->m_base + read_operand(ip)].heap_object();
+                static_cast<CellObject*>(cell)->set(pop());
+                ip += OPERAND_WIDTH;
+                VM_NEXT;
+            }
+
+            VM_OP(GetFree)
+                m_stack.push_back((*frame->m_free)[read_operand(ip)].as<CellObject>().value());
+                ip += OPERAND_WIDTH;
+                VM_NEXT;
+
+            VM_OP(GetFreeCell)
+                m_stack.push_back((*frame->m_free)[read_operand(ip)]);
+                ip += OPERAND_WIDTH;
+                VM_NEXT;
+
+            VM_OP(Closure)
+            {
+                const auto& constant = (*m_constants)[read_operand(ip)];
+                const auto  num_free = read_operand(ip + OPERAND_WIDTH);
+                ip += 2 * OPERAND_WIDTH;
+
+                const auto free_begin = m_stack.end() - num_free;
+                auto       free       = obj::FreeVariables(std::make_move_iterator(free_begin),
+                                                           std::make_move_iterator(m_stack.end()));
+                m_stack.erase(free_begin, m_stack.end());
+
+                const auto* fn = &constant.as<ClosureObject>().fn();
+                m_stack.push_back(obj::make_closure(fn, std::move(free)));
+                VM_NEXT;
+            }
+
+            VM_OP(Call)
+            {
+                const auto argc = read_operand(ip);
+                ip += OPERAND_WIDTH;
+
+                const auto& callee = m_stack[m_stack.size() - 1 - argc];
+                if (callee.type() != ObjectType::Closure)
+                    return fail(ops::not_fn_error(callee));
+
+                const auto& closure = callee.as<ClosureObject>();
+                const auto& fn      = closure.fn();
+                if (argc != fn.m_num_params)
+                    return fail(ops::wrong_args_error(fn.m_num_params, argc));
+
+                // The bottom frame is the script's, not a call's
+                if (m_frames.size() > m_max_depth)
+                    return fail(ops::stack_overflow_error(m_max_depth));
+
+                const auto* free = &closure.free();
+                const auto  base = m_stack.size() - argc;
+                m_stack.resize(base + fn.m_num_locals, Object{ObjectType::Unbound});
+
+                frame->m_ip = ip;
+                m_frames.push_back(Frame{fn.m_instructions.data(), fn.m_instructions.data(),
+                                         free, base});
+                frame = &m_frames.back();
+                ip    = frame->m_ip;
+
+                gc::heap().safepoint();
+                VM_NEXT;
+            }
+
+            VM_OP(TailCall)
+            {
+                const auto argc = read_operand(ip);
+
+                const auto  callee_pos = m_stack.size() - 1 - argc;
+                const auto& callee     = m_stack[callee_pos];
+                if (callee.type() != ObjectType::Closure)
+                    return fail(ops::not_fn_error(callee));
+
+                const auto& closure = callee.as<ClosureObject>();
+                const auto& fn      = closure.fn();
+                if (argc != fn.m_num_params)
+                    return fail(ops::wrong_args_error(fn.m_num_params, argc));
+
+                // The callee and its arguments take the place of the running
+                // call's, and its locals start out unbound as after a Call
+                const auto base = frame->m_base;
+                std::move(m_stack.begin() + static_cast<std::ptrdiff_t>(callee_pos), m_stack.end(),
+                          m_stack.begin() + static_cast<std::ptrdiff_t>(base - 1));
+                m_stack.resize(base + argc);
+                m_stack.resize(base + fn.m_num_locals, Object{ObjectType::Unbound});
+
+                *frame = Frame{fn.m_instructions.data(), fn.m_instructions.data(), &closure.free(), base};
+                ip     = frame->m_ip;
+
+                gc::heap().safepoint();
+                VM_NEXT;
+            }
+
+            VM_OP(ReturnValue)
+            {
+                auto result = pop();
+                if (m_frames.size() == 1)
+                {
+                    m_frames.clear();
+                    m_stack.clear();
+                    return result;
+                }
+
+                m_stack.resize(frame->m_base - 1);
+                m_stack.push_back(std::move(result));
+
+                m_frames.pop_back();
+                frame = &m_frames.back();
+                ip    = frame->m_ip;
+                VM_NEXT;
+            }
+#ifndef PUNKY_VM_THREADED
+        }
+    }
+#endif
+
+#undef VM_OP
+#undef VM_NEXT
+#undef VM_PROFILE
+}
+
+void VM::trace(gc::Tracer& tracer) const
+{
+    for (const auto& obj : m_stack)
+        tracer.mark(obj);
+
+    for (const auto& global : m_globals)
+    {
+        if (global.has_value())
+            tracer.mark(global.value());
+    }
+}
+
+auto VM::fail(Object error) -> Object
+{
+    m_frames.clear();
+    m_stack.clear();
+    return error;
+}
+
+auto VM::pop() -> Object
+{
+    auto obj = std::move(m_stack.back());
+    m_stack.pop_back();
+    return obj;
+}
+
+static constexpr auto infix_token(OpCode op) -> TokenType
+{
+    switch (op)
+    {
+        case OpCode::Add:
+        case OpCode::AddLocalConst:
+            return TokenType::Plus;
+        case OpCode::Sub:
+        case OpCode::SubLocalConst:
+            return TokenType::Minus;
+        case OpCode::Mul:
+            return TokenType::Asterisk;
+        case OpCode::Div:
+            return TokenType::Slash;
+        case OpCode::Equal:
+        case OpCode::JumpIfNotEqual:
+            return TokenType::EqualEqual;
+        case OpCode::NotEqual:
+            return TokenType::BangEqual;
+        case OpCode::Greater:
+        case OpCode::JumpIfNotGreater:
+            return TokenType::Greater;
+        case OpCode::Less:
+        case OpCode::JumpIfNotLess:
+        default:
+            return TokenType::Less;
+    }
+}
+
+}  // namespace punky::vm
@@ -77,13 +77,13 @@ const LetStmt* AstNode::let_stmt() const
 
 std::string ExprNode::token_literal() const
 {
-    return m_token.m_literal.has_value() ? m_token.m_literal.value()
+    return m_token.m_literal.has_value() ? std::string{m_token.m_literal.value()}
                                          : tok::type_to_string(m_token.m_type);
 }
 
 std::string StmtNode::token_literal() const
 {
-    return m_token.m_literal.has_value() ? m_token.m_literal.value()
+    return m_token.m_literal.has_value() ? std::string{m_token.m_literal.value()}
                                          : tok::type_to_string(m_token.m_type);
 }
 
@@ -101,9 +101,9 @@ std::string Program::to_string() const
     return prog_str;
 }
 
-void Program::push_stmt(std::unique_ptr<ast::StmtNode> stmt)
+void Program::push_stmt(StmtNodePtr stmt)
 {
-    m_statements.push_back(std::move(stmt));
+    m_statements.push_back(stmt);
 }
 
 std::string LetStmt::to_string() const
@@ -129,9 +129,9 @@ std::string ExpressionStmt::to_string() const
                         : "";
 }
 
-void BlockStmt::push_stmt(std::unique_ptr<ast::StmtNode> stmt)
+void BlockStmt::push_stmt(StmtNodePtr stmt)
 {
-    m_blk_statements.push_back(std::move(stmt));
+    m_blk_statements.push_back(stmt);
 }
 
 std::string BlockStmt::to_string() const
@@ -208,12 +208,15 @@ std::string CallExpression::to_string() const
 ExprNodeVector* CallExpression::arguments() const
 {
     if (m_arguments.has_value())
-        return m_arguments.value().get();
+        return m_arguments.value();
     return nullptr;
 }
 
 std::string FunctionLiteral::to_string() const
 {
+    if (!m_source.empty())
+        return m_source;
+
     std::string fn_str{token_literal() + "("};
     if (m_body)
     {
@@ -238,7 +241,7 @@ std::string FunctionLiteral::to_string() const
 std::vector<punky::ast::Identifier>* FunctionLiteral::params() const
 {
     if (m_params.has_value())
-        return m_params.value().get();
+        return m_params.value();
     return nullptr;
 }
 
@@ -1,41 +1,133 @@
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
-#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
-#include <punky/Environment.hpp>
-#include <punky/Evaluator.hpp>
-#include <punky/Lexer.hpp>
-#include <punky/Parser.hpp>
-#include <punky/ast.hpp>
+#include <punky/Heap.hpp>
+#include <punky/Object.hpp>
+#include <punky/Session.hpp>
+#include <punky/operators.hpp>
+#include <punky/SourceFile.hpp>
 #include <punky/readline.hpp>
 
-static void repl()
+using punky::repl::Engine;
+
+static constexpr std::string_view USAGE =
+  "usage: punky [--vm | --thunks] [--max-depth=<calls>] [--gc-threshold=<bytes>] [--gc-stats] [<file> | -]\n";
+
+static auto parse_size(std::string_view str) -> std::optional<std::size_t>
 {
-    auto repl_env = punky::env::Environment();
+    std::size_t size{};
+
+    const auto* end = str.data() + str.size();
+    if (const auto [ptr, ec] = std::from_chars(str.data(), end, size); ec != std::errc{} || ptr != end)
+        return std::nullopt;
+    return size;
+}
+
+static void repl(Engine engine, std::size_t max_depth)
+{
+    auto session = punky::repl::Session{engine, max_depth};
 
     std::string line;
     while (readline::read(line))
     {
-        auto lex = punky::lex::Lexer{std::move(line)};
-        auto par = punky::par::Parser{lex};
-
-        auto prog = par.parse_program();
-        if (std::holds_alternative<bool>(prog))  // TODO(piyush): Catch instead
+        const auto res = session.run_line(line);
+        if (!res.has_value())  // TODO(piyush): Catch instead
             continue;
 
-        auto eval = punky::eval::Evaluator{std::move(
-          std::get<std::unique_ptr<punky::ast::Program>>(prog))};
-
-        auto res = eval.interpret(repl_env);
-
-        if (const auto out = punky::obj::inspect(res); !out.empty())
+        if (const auto out = punky::obj::inspect(res.value()); !out.empty())
             std::cout << out << std::endl;
     }
 }
 
-int main()
+// The whole script is one chunk: it is parsed once, straight out of the
+// SourceFile, and only its final value is printed.
+static int run_script(Engine engine, std::size_t max_depth, const punky::io::SourceFile& source)
+{
+    auto session = punky::repl::Session{engine, max_depth};
+
+    const auto res = session.run(source.text());
+    if (!res.has_value())
+        return 1;
+
+    if (const auto out = punky::obj::inspect(res.value()); !out.empty())
+        std::cout << out << std::endl;
+
+    return res->type() == punky::obj::ObjectType::Error ? 1 : 0;
+}
+
+int main(int argc, char* argv[])
 {
-    repl();
+    auto engine    = Engine::Evaluator;
+    auto max_depth = punky::ops::DEFAULT_MAX_DEPTH;
+    auto gc_stats  = false;
+
+    std::optional<std::string> path;
+
+    static constexpr std::string_view MAX_DEPTH    = "--max-depth=";
+    static constexpr std::string_view GC_THRESHOLD = "--gc-threshold=";
+
+    const std::vector<std::string_view> args(argv + 1, argv + argc);
+    for (const auto arg : args)
+    {
+        if (arg == "--vm")
+            engine = Engine::VM;
+        else if (arg == "--thunks")
+            engine = Engine::Thunks;
+        else if (arg == "--gc-stats")
+            gc_stats = true;
+        else if (arg.substr(0, MAX_DEPTH.size()) == MAX_DEPTH)
+        {
+            const auto depth = parse_size(arg.substr(MAX_DEPTH.size()));
+            if (!depth.has_value())
+            {
+                std::cerr << USAGE;
+                return 1;
+            }
+            max_depth = depth.value();
+        }
+        else if (arg.substr(0, GC_THRESHOLD.size()) == GC_THRESHOLD)
+        {
+            const auto bytes = parse_size(arg.substr(GC_THRESHOLD.size()));
+            if (!bytes.has_value())
+            {
+                std::cerr << USAGE;
+                return 1;
+            }
+            punky::gc::heap().set_threshold(bytes.value());
+        }
+        else if (!path.has_value() && (arg == "-" || (!arg.empty() && arg.front() != '-')))
+            path = std::string{arg};
+        else
+        {
+            std::cerr << USAGE;
+            return 1;
+        }
+    }
+
+    auto status = 0;
+    if (!path.has_value())
+    {
+        repl(engine, max_depth);
+    }
+    else if (const auto source = punky::io::SourceFile::open(path.value()); source.has_value())
+    {
+        status = run_script(engine, max_depth, source.value());
+    }
+    else
+    {
+        std::cerr << "punky: " << path.value() << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    if (gc_stats)
+        std::cerr << punky::gc::to_string(punky::gc::heap().stats()) << std::endl;
 
-    return 0;
+    return status;
 }
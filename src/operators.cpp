@@ -0,0 +1,231 @@
+#include "punky/operators.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+
+#include <punky/Object.hpp>
+#include <punky/Token.hpp>
+
+namespace punky::ops
+{
+
+using punky::obj::ObjectType;
+
+static Object bang_prefix(const Object& right);
+static Object minus_prefix(const Object& right);
+
+static Object int_infix(const TokenType& op, const Object& left, const Object& right);
+static Object bool_infix(const TokenType& op, const Object& left, const Object& right);
+
+static Object unknown_op_error(const Object& right);
+static Object unknown_op_error(const TokenType& op, const Object& right);
+static Object unknown_op_error(const TokenType& op, const Object& left, const Object& right);
+static Object type_mismatch_error(const TokenType& op, const Object& left, const Object& right);
+
+Object prefix(const TokenType& op, const Object& right)
+{
+    switch (op)
+    {
+        case TokenType::Bang:
+            return bang_prefix(right);
+
+        case TokenType::Minus:
+            return minus_prefix(right);
+
+        default:
+            return unknown_op_error(op, right);
+    }
+}
+
+Object infix(const TokenType& op, const Object& left, const Object& right)
+{
+    if (left.type() == ObjectType::Int && right.type() == ObjectType::Int)
+        return int_infix(op, left, right);
+
+    if (left.type() == ObjectType::Boolean && right.type() == ObjectType::Boolean)
+        return bool_infix(op, left, right);
+
+    if (left.type() != right.type())
+        return type_mismatch_error(op, left, right);
+
+    return unknown_op_error(op, left, right);
+}
+
+bool is_truthy(const Object& obj)
+{
+    switch (obj.type())
+    {
+        case ObjectType::Boolean:
+            return obj.as_bool();
+
+        case ObjectType::Null:
+            return false;
+
+        default:
+            return true;
+    }
+}
+
+bool is_error(const Object& obj)
+{
+    return obj.type() == ObjectType::Error;
+}
+
+bool is_abrupt(const Object& obj)
+{
+    return obj.returning() || is_error(obj);
+}
+
+Object pending_tail_call()
+{
+    auto tail_call = Object{ObjectType::Null};
+    tail_call.set_returning(true);
+    return tail_call;
+}
+
+static Object bang_prefix(const Object& right)
+{
+    switch (right.type())
+    {
+        case ObjectType::Boolean:
+            return Object{!right.as_bool()};
+
+        case ObjectType::Null:
+            return Object{true};
+
+        default:
+            return Object{false};
+    }
+}
+
+static Object minus_prefix(const Object& right)
+{
+    if (right.type() == ObjectType::Int)
+    {
+        // The one int whose negation does not fit
+        const auto value = right.as_int();
+        if (value == std::numeric_limits<std::int64_t>::min())
+            return int_overflow_error(TokenType::Minus, value);
+        return Object{-value};
+    }
+
+    return unknown_op_error(right);
+}
+
+static Object int_infix(const TokenType& op, const Object& left, const Object& right)
+{
+    const auto left_val  = left.as_int();
+    const auto right_val = right.as_int();
+
+    switch (op)
+    {
+        case TokenType::Plus:
+            return int_add(left_val, right_val);
+
+        case TokenType::Minus:
+            return int_sub(left_val, right_val);
+
+        case TokenType::Asterisk:
+            return int_mul(left_val, right_val);
+
+        case TokenType::Slash:
+            return int_div(left_val, right_val);
+
+        case TokenType::Less:
+            return int_less(left_val, right_val);
+
+        case TokenType::Greater:
+            return int_greater(left_val, right_val);
+
+        case TokenType::EqualEqual:
+            return int_equal(left_val, right_val);
+
+        case TokenType::BangEqual:
+            return int_not_equal(left_val, right_val);
+
+        default:
+            return unknown_op_error(op, left, right);
+    }
+}
+
+static Object bool_infix(const TokenType& op, const Object& left, const Object& right)
+{
+    const auto left_val  = left.as_bool();
+    const auto right_val = right.as_bool();
+
+    switch (op)
+    {
+        case TokenType::EqualEqual:
+            return Object{left_val == right_val};
+
+        case TokenType::BangEqual:
+            return Object{left_val != right_val};
+
+        default:
+            return unknown_op_error(op, left, right);
+    }
+}
+
+static Object unknown_op_error(const Object& right)
+{
+    return obj::make_error("unknown operator: -" + obj::type_to_string(right.type()));
+}
+
+static Object unknown_op_error(const TokenType& op, const Object& right)
+{
+    return obj::make_error("unknown operator: " + tok::type_to_string(op)
+                           + obj::type_to_string(right.type()));
+}
+
+static Object unknown_op_error(const TokenType& op, const Object& left, const Object& right)
+{
+    return obj::make_error("unknown operator: " + obj::type_to_string(left.type())
+                           + " " + tok::type_to_string(op) + " " + obj::type_to_string(right.type()));
+}
+
+static Object type_mismatch_error(const TokenType& op, const Object& left, const Object& right)
+{
+    return obj::make_error("type mismatch: " + obj::type_to_string(left.type())
+                           + " " + tok::type_to_string(op) + " " + obj::type_to_string(right.type()));
+}
+
+Object int_overflow_error(const TokenType& op, std::int64_t left, std::int64_t right)
+{
+    return obj::make_error("integer overflow: " + std::to_string(left) + " " + tok::type_to_string(op)
+                           + " " + std::to_string(right));
+}
+
+Object int_overflow_error(const TokenType& op, std::int64_t right)
+{
+    return obj::make_error("integer overflow: " + tok::type_to_string(op) + std::to_string(right));
+}
+
+Object division_by_zero_error(std::int64_t left)
+{
+    return obj::make_error("division by zero: " + std::to_string(left) + " / 0");
+}
+
+Object unknown_ident_error(std::string_view name)
+{
+    return obj::make_error("identifier not found: " + std::string{name});
+}
+
+Object not_fn_error(const Object& not_fn)
+{
+    return obj::make_error("not a function: " + obj::type_to_string(not_fn.type()));
+}
+
+Object wrong_args_error(std::size_t want, std::size_t got)
+{
+    return obj::make_error("wrong number of arguments: want=" + std::to_string(want)
+                           + ", got=" + std::to_string(got));
+}
+
+Object stack_overflow_error(std::size_t max_depth)
+{
+    return obj::make_error("stack overflow: more than " + std::to_string(max_depth) + " nested calls");
+}
+
+}  // namespace punky::ops
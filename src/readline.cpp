@@ -1,3 +1,4 @@
+#include <iostream>
 #include <string>
 
 #include "linenoise.hpp"
@@ -12,7 +13,9 @@ bool read(std::string& input, const std::string& prompt,
 
     const auto eof = linenoise::Readline(prompt.c_str(), input);
 
-    if (eof)
+    // Without a terminal linenoise falls back to std::getline and never
+    // reports the end of input itself
+    if (eof || std::cin.fail())
         return false;
 
     linenoise::AddHistory(input.c_str());
@@ -1,21 +1,121 @@
-#include <cctype>
+#include "punky/utils.hpp"
+
+#include <cstddef>
+#include <string_view>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 namespace punky::utils
 {
 
-bool is_letter(char ch)
+#if defined(__AVX2__)
+
+using Block = __m256i;
+
+static constexpr std::size_t BLOCK_SIZE = 32;
+
+static Block load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const Block*>(p)); }
+static Block splat(char ch) { return _mm256_set1_epi8(ch); }
+static Block either(Block a, Block b) { return _mm256_or_si256(a, b); }
+static Block equal(Block a, Block b) { return _mm256_cmpeq_epi8(a, b); }
+static Block less(Block a, Block b) { return _mm256_cmpgt_epi8(b, a); }
+static Block sub(Block a, Block b) { return _mm256_sub_epi8(a, b); }
+
+static unsigned mask(Block b) { return static_cast<unsigned>(_mm256_movemask_epi8(b)); }
+
+static constexpr unsigned FULL_MASK = 0xFFFFFFFFU;
+
+#elif defined(__SSE2__)
+
+using Block = __m128i;
+
+static constexpr std::size_t BLOCK_SIZE = 16;
+
+static Block load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const Block*>(p)); }
+static Block splat(char ch) { return _mm_set1_epi8(ch); }
+static Block either(Block a, Block b) { return _mm_or_si128(a, b); }
+static Block equal(Block a, Block b) { return _mm_cmpeq_epi8(a, b); }
+static Block less(Block a, Block b) { return _mm_cmplt_epi8(a, b); }
+static Block sub(Block a, Block b) { return _mm_sub_epi8(a, b); }
+
+static unsigned mask(Block b) { return static_cast<unsigned>(_mm_movemask_epi8(b)); }
+
+static constexpr unsigned FULL_MASK = 0xFFFFU;
+
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__)
+
+// Lanes holding a byte in [lo, hi]. Biasing by 128 turns the unsigned range
+// check into a single signed comparison, as there is no unsigned one.
+static Block in_range(Block bytes, char lo, char hi)
+{
+    const auto biased = sub(bytes, splat(static_cast<char>(lo + 128)));
+    return less(biased, splat(static_cast<char>(hi - lo - 127)));
+}
+
+static Block letters(Block bytes)
+{
+    // Setting bit 5 folds upper case onto lower case
+    return either(in_range(either(bytes, splat(0x20)), 'a', 'z'), equal(bytes, splat('_')));
+}
+
+static Block digits(Block bytes)
+{
+    return in_range(bytes, '0', '9');
+}
+
+static Block whitespace(Block bytes)
+{
+    return either(in_range(bytes, '\t', '\r'), equal(bytes, splat(' ')));
+}
+
+// Stops at the first unmatched byte, or where less than a block is left
+template <typename Classify>
+static std::size_t skip_blocks(std::string_view src, std::size_t pos, Classify classify)
+{
+    for (; pos + BLOCK_SIZE <= src.size(); pos += BLOCK_SIZE)
+    {
+        if (const auto matched = mask(classify(load(src.data() + pos))); matched != FULL_MASK)
+            return pos + static_cast<std::size_t>(__builtin_ctz(~matched));
+    }
+    return pos;
+}
+
+#endif
+
+template <typename Scalar>
+static std::size_t skip_scalar(std::string_view src, std::size_t pos, Scalar scalar)
+{
+    while (pos < src.size() && scalar(src[pos]))
+        ++pos;
+    return pos;
+}
+
+std::size_t skip_letters(std::string_view src, std::size_t pos)
 {
-    return (std::isalpha(ch) != 0) || ch == '_';
+#if defined(__AVX2__) || defined(__SSE2__)
+    pos = skip_blocks(src, pos, letters);
+#endif
+    return skip_scalar(src, pos, is_letter);
 }
 
-bool is_digit(char ch)
+std::size_t skip_digits(std::string_view src, std::size_t pos)
 {
-    return std::isdigit(ch) != 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+    pos = skip_blocks(src, pos, digits);
+#endif
+    return skip_scalar(src, pos, is_digit);
 }
 
-bool is_whitespace(char ch)
+std::size_t skip_whitespace(std::string_view src, std::size_t pos)
 {
-    return std::isspace(ch) != 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+    pos = skip_blocks(src, pos, whitespace);
+#endif
+    return skip_scalar(src, pos, is_whitespace);
 }
 
 }  // namespace punky::utils
@@ -0,0 +1,77 @@
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+
+#include <punky/CallStack.hpp>
+#include <punky/Object.hpp>
+
+namespace punky::test
+{
+
+using punky::obj::Object;
+
+// Deep enough that the calls run on several stack segments
+static constexpr std::size_t DEPTH = 200000;
+
+// Nests depth calls through calls.run(), throwing from the innermost one if
+// throw_at is reached
+static auto nest(eval::CallStack& calls, std::size_t depth, std::size_t throw_at) -> Object
+{
+    if (depth == 0)
+        return Object{std::int64_t{0}};
+    if (depth == throw_at)
+        throw std::runtime_error{"thrown on a segment"};
+
+    if (!calls.push(nullptr))
+        throw std::logic_error{"maximum depth reached"};
+    auto value = Object{};
+    try
+    {
+        value = calls.run([&calls, depth, throw_at]() { return nest(calls, depth - 1, throw_at); });
+    }
+    catch (...)
+    {
+        calls.pop();
+        throw;
+    }
+    calls.pop();
+
+    return Object{value.as_int() + 1};
+}
+
+}  // namespace punky::test
+
+int main()
+{
+    using namespace punky;
+
+    auto calls    = eval::CallStack{2 * test::DEPTH};
+    int  failures = 0;
+
+    if (test::nest(calls, test::DEPTH, 0).as_int() != static_cast<std::int64_t>(test::DEPTH))
+    {
+        ++failures;
+        std::cout << "deep nesting returned the wrong value\n";
+    }
+
+    // The exception reaches the caller, and the segments are free again
+    try
+    {
+        test::nest(calls, test::DEPTH, 1);
+        ++failures;
+        std::cout << "the exception was lost\n";
+    }
+    catch (const std::runtime_error&)
+    {
+    }
+
+    if (test::nest(calls, test::DEPTH, 0).as_int() != static_cast<std::int64_t>(test::DEPTH))
+    {
+        ++failures;
+        std::cout << "nesting after an exception returned the wrong value\n";
+    }
+
+    std::cout << failures << " failures\n";
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <punky/Object.hpp>
+#include <punky/Session.hpp>
+
+namespace punky::test
+{
+
+// A script and what every engine must print for it, where the Evaluator is
+// the reference the others follow
+struct Case
+{
+    std::string m_source;
+    std::string m_expected;
+};
+
+static constexpr repl::Engine ENGINES[] = {repl::Engine::Evaluator, repl::Engine::Thunks,
+                                          repl::Engine::VM};
+
+static auto engine_name(repl::Engine engine) -> std::string_view
+{
+    switch (engine)
+    {
+        case repl::Engine::Evaluator:
+            return "evaluator";
+        case repl::Engine::Thunks:
+            return "thunks";
+        case repl::Engine::VM:
+        default:
+            return "vm";
+    }
+}
+
+// Identifiers are letters only: va, vb, ..., vz, vba, ...
+static auto letter_name(int index) -> std::string
+{
+    std::string name;
+    do
+    {
+        name.insert(name.begin(), static_cast<char>('a' + index % 26));
+        index /= 26;
+    } while (index > 0);
+    return "v" + name;
+}
+
+// More locals, globals and code than a narrow operand can address
+static auto many_locals(int count) -> Case
+{
+    std::string body;
+    for (int i = 0; i < count; ++i)
+        body.append("let " + letter_name(i) + " = " + std::to_string(i) + "; ");
+    return {"let f = fn() { " + body + letter_name(count - 1) + " }; f()",
+            std::to_string(count - 1)};
+}
+
+static auto many_globals(int count) -> Case
+{
+    std::string src;
+    for (int i = 0; i < count; ++i)
+        src.append("let " + letter_name(i) + " = " + std::to_string(i) + ";\n");
+    return {src + letter_name(count - 1), std::to_string(count - 1)};
+}
+
+static auto long_jump(int statements) -> Case
+{
+    std::string branch;
+    for (int i = 0; i < statements; ++i)
+        branch.append("1 + 2 * x; ");
+    return {"let x = 3; if (x < 2) { " + branch + "5 } else { 7 }", "7"};
+}
+
+static auto cases() -> std::vector<Case>
+{
+    return {
+      {"let fib = fn(n) { if (n < 2) { n } else { fib(n - 1) + fib(n - 2) } }; fib(15)", "610"},
+      {"let adder = fn(a) { fn(b) { a + b } }; adder(2)(3)", "5"},
+      {"let mk = fn(a) { fn(b) { fn(c) { a + b + c } } }; mk(1)(2)(3)", "6"},
+      {"let f = fn(x) { x + 1 }; f", "fn(x) { (x + 1) }"},
+      {"let sum = fn(n, acc) { if (n == 0) { acc } else { sum(n - 1, acc + n) } }; sum(100000, 0)",
+       "5000050000"},
+      {"10 / 0", "division by zero: 10 / 0"},
+      {"-(-9223372036854775807 - 1)", "integer overflow: --9223372036854775808"},
+      {"let f = fn(x) { -x }; f(-9223372036854775807 - 1)", "integer overflow: --9223372036854775808"},
+      {"-(-9223372036854775807)", "9223372036854775807"},
+      {"fn(x) { x }(1, 2)", "wrong number of arguments: want=1, got=2"},
+
+      // Closures see the bindings of the call they were made in, not a copy
+      {"let f = fn() { let x = 1; let g = fn() { x }; let x = 2; g() }; f()", "2"},
+      {"let f = fn() { let g = fn() { y }; let y = 3; g() }; f()", "3"},
+      {"let f = fn() { let a = 1; let g = fn() { a }; let a = g() + 1; let h = fn() { a }; h() }; f()", "2"},
+
+      // Local functions may call ones bound after them
+      {"let f = fn() {"
+       "  let a = fn(n) { if (n == 0) { 0 } else { b(n - 1) } };"
+       "  let b = fn(n) { a(n) };"
+       "  a(3)"
+       "}; f()",
+       "0"},
+      {"let b = fn(n) { 99 };"
+       "let f = fn() {"
+       "  let a = fn(n) { if (n == 0) { 0 } else { b(n - 1) } };"
+       "  let b = fn(n) { a(n) };"
+       "  a(3)"
+       "}; f()",
+       "0"},
+
+      // A local that is not bound yet gives way to an enclosing binding
+      {"let x = 1; let f = fn(c) { if (c) { let x = 2; } x }; f(false)", "1"},
+      {"let x = 1; let f = fn(c) { if (c) { let x = 2; } x }; f(true)", "2"},
+      {"let y = 7; let f = fn() { let g = fn() { y }; let r = g(); let y = 3; r }; f()", "7"},
+      {"let f = fn() { let x = 1; let g = fn() { let x = x + 1; x }; g() + x }; f()", "3"},
+      {"let f = fn(c) { if (c) { let y = 1 }; y }; f(false)", "identifier not found: y"},
+      {"let f = fn() { let g = fn() { m }; g() }; f()", "identifier not found: m"},
+
+      // Tail calls, including one made inside another call's arguments
+      {"let f = fn(x) { x * 10 }; let g = fn(a) { a };"
+       "let h = fn(c) { g(if (c) { return f(3) } else { 1 }) }; h(true)",
+       "30"},
+      {"let g = fn(a) { a }; let f = fn() { g(1, 2) }; f()", "wrong number of arguments: want=1, got=2"},
+      {"let f = fn() { return 5(1) }; f()", "not a function: int"},
+      {"let f = fn(n) { if (n == 0) { fn(a, b) { a * b } } else { f(n - 1) } }; f(3)(6, 7)", "42"},
+      {"let f = fn(n) { if (true) { if (n == 0) { 0 } else { f(n - 1) } } }; f(100000)", "0"},
+
+      // A repeated parameter name refers to the last argument
+      {"fn(x, x) { x }(1, 2)", "2"},
+
+      many_locals(300),
+      many_globals(70000),
+      long_jump(12000),
+    };
+}
+
+}  // namespace punky::test
+
+// Runs every case on every engine, reporting each output that differs from
+// the expected one
+int main()
+{
+    using namespace punky;
+
+    int failures = 0;
+    for (const auto& test : test::cases())
+    {
+        for (const auto engine : test::ENGINES)
+        {
+            auto       session = repl::Session{engine};
+            const auto result  = session.run(test.m_source);
+            const auto output  = result.has_value() ? obj::inspect(result.value()) : "(parse error)";
+            if (output == test.m_expected)
+                continue;
+
+            ++failures;
+            std::cout << test::engine_name(engine) << ": " << test.m_source.substr(0, 120) << "\n"
+                      << "  expected: " << test.m_expected << "\n"
+                      << "  got:      " << output << "\n";
+        }
+    }
+
+    std::cout << failures << " failures\n";
+    return failures == 0 ? 0 : 1;
+}
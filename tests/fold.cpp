@@ -0,0 +1,105 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include <punky/Arena.hpp>
+#include <punky/FlatAst.hpp>
+#include <punky/Folder.hpp>
+#include <punky/Lexer.hpp>
+#include <punky/Object.hpp>
+#include <punky/Parser.hpp>
+#include <punky/ast.hpp>
+
+namespace punky::test
+{
+
+// A script, the Program the Folder leaves of it, and the value fold() finds
+// for its last expression, "-" if none
+struct Case
+{
+    std::string m_source;
+    std::string m_folded;
+    std::string m_value;
+};
+
+static auto cases() -> std::vector<Case>
+{
+    return {
+      {"1 + 2 * 3", "7", "7"},
+      {"-(1 + 2)", "-3", "-3"},
+      {"!(1 < 2)", "false", "false"},
+      {"true == (1 < 2)", "true", "true"},
+      {"x + 2 * 3", "(x + 6)", "-"},
+
+      // What fails at run time is left to fail then, and only if it runs
+      {"1 / 0", "(1 / 0)", "-"},
+      {"10 / (5 - 5)", "(10 / 0)", "-"},
+      {"9223372036854775807 + 1", "(9223372036854775807 + 1)", "-"},
+      {"-(-9223372036854775807 - 1)", "(- -9223372036854775808)", "-"},
+      {"5 + true", "(5 + true)", "-"},
+      {"if (false) { 1 / 0 } else { 2 }", "2", "2"},
+
+      // A constant condition leaves the branch it takes
+      {"if (1 < 2) { 10 } else { 20 }", "10", "10"},
+      {"if (0) { 10 } else { 20 }", "10", "10"},
+      {"if (false) { 10 }", "if false { }", "-"},
+      {"if (false) { 10 } else { x; 20 }", "if true { x\n20 }", "-"},
+      {"if (x) { 1 + 1 }", "if x { 2 }", "-"},
+
+      // unless the other binds a name in the enclosing scope
+      {"if (true) { 1 } else { let a = 2; a }", "if true { 1 }else { let a = 2\na }", "-"},
+      {"if (false) { g(fn() { let a = 1; a }) } else { 2 }", "2", "2"},
+    };
+}
+
+static auto folded(std::string_view src) -> std::string
+{
+    auto arena = ast::Arena{};
+    auto lex   = lex::Lexer{arena.copy_source(src)};
+    auto prog  = std::get<ast::Program*>(par::Parser{lex, arena}.parse_program());
+    opt::Folder{arena}.fold(*prog);
+
+    // Each statement is printed on a line of its own
+    auto text = prog->to_string();
+    text.pop_back();
+    return text;
+}
+
+static auto flat_value(std::string_view src) -> std::string
+{
+    auto lex  = lex::Lexer{src};
+    auto flat = ast::FlatAst{};
+    std::get<const ast::FlatAst*>(par::FlatParser{lex, flat}.parse_program());
+
+    const auto  folds = opt::fold(flat);
+    const auto& value = folds.m_values[flat.expression(flat.statements(flat.root()).back())];
+    return value.has_value() ? obj::inspect(value.value()) : "-";
+}
+
+}  // namespace punky::test
+
+// The Folder and fold() must agree, as the tree engines run what one leaves
+// and the VM what the other does
+int main()
+{
+    using namespace punky;
+
+    int failures = 0;
+    for (const auto& test : test::cases())
+    {
+        const auto tree = test::folded(test.m_source);
+        const auto flat = test::flat_value(test.m_source);
+        if (tree == test.m_folded && flat == test.m_value)
+            continue;
+
+        ++failures;
+        std::cout << test.m_source << "\n"
+                  << "  expected: " << test.m_folded << ", " << test.m_value << "\n"
+                  << "  got:      " << tree << ", " << flat << "\n";
+    }
+
+    std::cout << failures << " failures\n";
+    return failures == 0 ? 0 : 1;
+}
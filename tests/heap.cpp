@@ -0,0 +1,141 @@
+#include <iostream>
+#include <string_view>
+
+#include <punky/Environment.hpp>
+#include <punky/Heap.hpp>
+#include <punky/Object.hpp>
+#include <punky/Session.hpp>
+
+namespace punky::test
+{
+
+static int s_failures = 0;
+
+static void check(bool passed, std::string_view what)
+{
+    if (passed)
+        return;
+
+    ++s_failures;
+    std::cout << "failed: " << what << "\n";
+}
+
+// What is live right after a collection, for comparing against later
+static auto collected() -> gc::HeapStats
+{
+    gc::heap().collect();
+    return gc::heap().stats();
+}
+
+static void unreachable_objects_are_freed()
+{
+    const auto before = collected();
+
+    for (int i = 0; i < 100; ++i)
+        static_cast<void>(obj::make_error("garbage"));
+    check(gc::heap().stats().m_live_objects == before.m_live_objects + 100, "allocations are live until collected");
+
+    const auto after = collected();
+    check(after.m_live_objects == before.m_live_objects, "unreachable objects are freed");
+    check(after.m_freed_bytes > before.m_freed_bytes, "freed bytes are counted");
+    check(after.m_collections == before.m_collections + 1, "each collection is counted");
+}
+
+static void rooted_objects_survive()
+{
+    const auto before = collected();
+
+    const auto kept = obj::make_error("kept");
+    const auto text = obj::inspect(kept);
+    {
+        const auto root  = gc::Root{kept.heap_object()};
+        const auto after = collected();
+        check(after.m_live_objects == before.m_live_objects + 1, "a rooted object survives a collection");
+        check(obj::inspect(kept) == text, "a rooted object is intact after a collection");
+    }
+
+    check(collected().m_live_objects == before.m_live_objects, "an object is freed once its Root is gone");
+}
+
+static void environments_keep_their_values()
+{
+    const auto before = collected();
+
+    auto*      outer = env::Environment::make(nullptr, 1);
+    const auto root  = gc::Root{outer};
+    auto*      inner = env::Environment::make(outer, 1);
+    outer->set(0, obj::make_error("in outer"));
+    inner->set(0, obj::make_error("in inner"));
+
+    // Only outer is rooted, so inner goes and outer's value stays
+    const auto after = collected();
+    check(after.m_live_objects == before.m_live_objects + 2, "an Environment keeps its values alive");
+    check(obj::inspect(outer->get(0, 0).value()) == obj::inspect(obj::make_error("in outer")),
+          "a value bound in a rooted Environment is intact");
+}
+
+static void release_young_restores_the_nursery()
+{
+    const auto before = collected();
+
+    auto* first  = env::Environment::make_young(nullptr, 4);
+    auto* second = env::Environment::make_young(first, 4);
+    check(second != first, "young Environments do not overlap");
+    first->set(0, obj::make_error("young value"));
+
+    // Young Environments are roots, so their values survive
+    const auto during = collected();
+    check(during.m_young_objects == before.m_young_objects + 2, "young allocations are counted");
+    check(during.m_live_objects == before.m_live_objects + 1, "the value of a young Environment survives");
+
+    // Releasing the older one releases both, and the nursery reuses the space
+    env::Environment::release(first);
+    auto* again = env::Environment::make_young(nullptr, 4);
+    check(again == first, "release_young() moves the top of the nursery back");
+    env::Environment::release(again);
+
+    check(collected().m_live_objects == before.m_live_objects, "a released Environment's values are freed");
+}
+
+// Every engine, collecting at each of its safepoints
+static void scripts_survive_collections()
+{
+    static constexpr std::string_view SCRIPT =
+      "let adder = fn(a) { fn(b) { a + b } };"
+      "let add_two = adder(2);"
+      "let fib = fn(n) { if (n < 2) { n } else { fib(n - 1) + fib(n - 2) } };"
+      "let twice = fn(f, x) { f(f(x)) };"
+      "let counter = fn(n) { let next = fn() { n + 1 }; let n = next(); fn() { n } };"
+      "add_two(fib(15)) + twice(adder(3), 1) + counter(10)()";
+    static constexpr std::string_view EXPECTED = "630";
+
+    for (const auto engine : {repl::Engine::Evaluator, repl::Engine::Thunks, repl::Engine::VM})
+    {
+        const auto before = gc::heap().stats();
+
+        auto       session = repl::Session{engine};
+        const auto result  = session.run(SCRIPT);
+        check(result.has_value() && obj::inspect(result.value()) == EXPECTED,
+              "closures survive collections on every engine");
+        check(gc::heap().stats().m_collections > before.m_collections, "safepoints collect at threshold 0");
+    }
+}
+
+}  // namespace punky::test
+
+// As --gc-threshold=0 does for the interpreter
+int main()
+{
+    using namespace punky;
+
+    gc::heap().set_threshold(0);
+
+    test::unreachable_objects_are_freed();
+    test::rooted_objects_survive();
+    test::environments_keep_their_values();
+    test::release_young_restores_the_nursery();
+    test::scripts_survive_collections();
+
+    std::cout << test::s_failures << " failures\n";
+    return test::s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include <punky/Lexer.hpp>
+#include <punky/Token.hpp>
+#include <punky/utils.hpp>
+
+namespace punky::test
+{
+
+using punky::tok::TokenType;
+
+// Runs around the 16 and 32 byte blocks the scanners step by
+static constexpr std::size_t LENGTHS[] = {1, 15, 16, 17, 31, 32, 33, 64, 65};
+
+static int s_failures = 0;
+
+static void check(bool passed, std::string_view what, std::string_view src)
+{
+    if (passed)
+        return;
+
+    ++s_failures;
+    std::cout << "failed: " << what << " on \"" << src << "\"\n";
+}
+
+using Skip = std::size_t (*)(std::string_view, std::size_t);
+
+// A run of length of fill at offset, ended by each of stops in turn or by
+// the end of the source
+static void check_skip(std::string_view what, Skip skip, char fill, std::string_view stops)
+{
+    for (const auto length : LENGTHS)
+    {
+        for (std::size_t offset = 0; offset < 4; ++offset)
+        {
+            const auto run = std::string(offset, '.') + std::string(length, fill);
+            check(skip(run, offset) == run.size(), what, run);
+
+            for (const auto stop : stops)
+            {
+                const auto src = run + stop + std::string(length, fill);
+                check(skip(src, offset) == offset + length, what, src);
+            }
+        }
+    }
+}
+
+// Each byte just outside the class, and one with the high bit set
+static void skips_stop_at_the_first_byte_outside()
+{
+    check_skip("skip_letters", utils::skip_letters, 'a', "@[`{0 \x80\xff");
+    check_skip("skip_letters", utils::skip_letters, 'Z', "@[`{9\n\x80");
+    check_skip("skip_letters", utils::skip_letters, '_', "^`-\x80");
+    check_skip("skip_digits", utils::skip_digits, '7', "/:a \x80\xb0");
+    check_skip("skip_whitespace", utils::skip_whitespace, ' ', "!\x1f\x0ex\x80\xa0");
+    check_skip("skip_whitespace", utils::skip_whitespace, '\t', "!\x1f\x0e" "0\x80");
+}
+
+// The Lexer seeks past each run the scanners find, so every token after one
+// starts where the run ends
+static void lexer_seeks_past_each_run()
+{
+    for (const auto length : LENGTHS)
+    {
+        const auto ident  = std::string(length, 'x');
+        const auto number = std::string(length, '9');
+        const auto src    = ident + std::string(length, ' ') + number + std::string(length, '\n') + ";";
+
+        auto lexer = lex::Lexer{src};
+
+        const auto first = lexer.next_token();
+        check(first.m_type == TokenType::Identifier && first.m_literal == ident, "an identifier is lexed whole", src);
+
+        const auto second = lexer.next_token();
+        check(second.m_type == TokenType::Int && second.m_literal == number, "an integer is lexed whole", src);
+
+        check(lexer.next_token().m_type == TokenType::Semicolon, "whitespace is skipped whole", src);
+        check(lexer.next_token().m_type == TokenType::EOS, "the source ends after the last token", src);
+    }
+}
+
+}  // namespace punky::test
+
+int main()
+{
+    using namespace punky;
+
+    test::skips_stop_at_the_first_byte_outside();
+    test::lexer_seeks_past_each_run();
+
+    std::cout << test::s_failures << " failures\n";
+    return test::s_failures == 0 ? 0 : 1;
+}
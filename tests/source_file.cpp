@@ -0,0 +1,139 @@
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include <punky/Lexer.hpp>
+#include <punky/Object.hpp>
+#include <punky/Session.hpp>
+#include <punky/SourceFile.hpp>
+#include <punky/Token.hpp>
+
+namespace punky::test
+{
+
+using punky::tok::TokenType;
+
+static int s_failures = 0;
+
+static void check(bool passed, std::string_view what)
+{
+    if (passed)
+        return;
+
+    ++s_failures;
+    std::cout << "failed: " << what << "\n";
+}
+
+// A file of the test's own in the temporary directory, removed with it
+class TempFile
+{
+public:
+    TempFile(std::string_view name, std::string_view text) :
+      m_path{"/tmp/punky_test_" + std::to_string(::getpid()) + "_" + std::string{name}}
+    {
+        std::ofstream{m_path, std::ios::binary} << text;
+    }
+
+    TempFile(const TempFile& other)            = delete;
+    TempFile& operator=(const TempFile& other) = delete;
+
+    ~TempFile() { std::remove(m_path.c_str()); }
+
+    [[nodiscard]] const std::string& path() const { return m_path; }
+
+private:
+    std::string m_path;
+};
+
+static void missing_files_are_reported()
+{
+    errno           = 0;
+    const auto file = io::SourceFile::open("/tmp/punky_test_no_such_file.pk");
+    check(!file.has_value() && errno == ENOENT, "a missing file is reported with ENOENT");
+
+    errno          = 0;
+    const auto dir = io::SourceFile::open("/tmp");
+    check(!dir.has_value() && errno == EISDIR, "a directory is reported with EISDIR");
+}
+
+static void empty_files_are_empty()
+{
+    const auto temp = TempFile{"empty.pk", ""};
+    auto       file = io::SourceFile::open(temp.path());
+    check(file.has_value() && file->text().empty(), "an empty file has no text");
+
+    // Read into a buffer rather than mapped, which a move must not lose
+    auto moved = std::move(file.value());
+    check(moved.text().empty(), "a moved empty file has no text");
+
+    auto session = repl::Session{repl::Engine::Evaluator};
+    check(session.run(moved.text()).has_value(), "an empty script runs");
+}
+
+static void regular_files_are_read_whole()
+{
+    const auto text = std::string(100000, ' ') + "let a = 40;\na + 2";
+    const auto temp = TempFile{"large.pk", text};
+
+    auto file = io::SourceFile::open(temp.path());
+    check(file.has_value() && file->text() == text, "a file is read whole");
+
+    auto moved = std::move(file.value());
+    check(moved.text() == text, "a moved file keeps its text");
+
+    auto       session = repl::Session{repl::Engine::VM};
+    const auto result  = session.run(moved.text());
+    check(result.has_value() && obj::inspect(result.value()) == "42", "a file runs as one script");
+}
+
+static auto token_types(std::string_view src) -> std::vector<TokenType>
+{
+    auto lexer = lex::Lexer{src};
+
+    std::vector<TokenType> types;
+    for (auto tok = lexer.next_token(); tok.m_type != TokenType::EOS; tok = lexer.next_token())
+        types.push_back(tok.m_type);
+    return types;
+}
+
+// Scripts such as examples/punky.pk comment their lines
+static void comments_run_to_the_end_of_the_line()
+{
+    check(token_types("// only a comment").empty(), "a comment at the end of the source is skipped");
+    check(token_types("//\n//\n\n  // more\n").empty(), "consecutive comments are skipped");
+    check(token_types("6 / 2 // halved\n;") == std::vector{TokenType::Int, TokenType::Slash, TokenType::Int, TokenType::Semicolon},
+          "a single slash still divides");
+    check(token_types("a//b\nc") == std::vector{TokenType::Identifier, TokenType::Identifier},
+          "a comment may follow a token directly");
+
+    const auto temp = TempFile{"comments.pk", "// adds\nlet add = fn(a, b) { a + b }; // two\n\nadd(1, 2) // three"};
+    const auto file = io::SourceFile::open(temp.path());
+    check(file.has_value(), "a commented script is read");
+
+    auto       session = repl::Session{repl::Engine::Thunks};
+    const auto result  = file.has_value() ? session.run(file->text()) : std::nullopt;
+    check(result.has_value() && obj::inspect(result.value()) == "3", "a commented script runs");
+}
+
+}  // namespace punky::test
+
+int main()
+{
+    using namespace punky;
+
+    test::missing_files_are_reported();
+    test::empty_files_are_empty();
+    test::regular_files_are_read_whole();
+    test::comments_run_to_the_end_of_the_line();
+
+    std::cout << test::s_failures << " failures\n";
+    return test::s_failures == 0 ? 0 : 1;
+}